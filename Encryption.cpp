@@ -1,13 +1,497 @@
 // Encryption.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <span>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <ctime>
 
+// SSE2 is part of the x64 baseline, so it is always available there. AVX2 is not, so it is
+// compiled in on any x86 target and only selected at runtime once the CPU reports support for it.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define ENCRYPTION_HAS_AVX2 1
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENCRYPTION_HAS_SSE2 1
+#endif
+#endif
+
+// memory mapped file encryption uses the POSIX mapping API, other platforms use the streaming path instead
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ENCRYPTION_HAS_MMAP 1
+#endif
+
+// MSVC allows AVX2 intrinsics in any function, GCC and Clang need the function marked for that target
+#if defined(_MSC_VER)
+#define ENCRYPTION_TARGET_AVX2
+#else
+#define ENCRYPTION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// the widest kernel consumes 64 bytes of key stream per step, so the expanded key stream
+// must extend at least this far past the last key offset
+constexpr size_t key_stream_padding = 64;
+
+/// <summary>
+/// signature shared by every xor kernel
+/// </summary>
+/// 
+/// <param name="source">input bytes to process</param>
+/// <param name="output">where to write the transformed bytes (may be the same as source)</param>
+/// <param name="length">number of bytes to process</param>
+/// <param name="key_stream">key repeated out to key_length + key_stream_padding bytes</param>
+/// <param name="key_length">length of the original key</param>
+/// <param name="key_offset">position in the key that lines up with source[0]</param>
+typedef void (*xor_kernel)(const char* source, char* output, size_t length, const char* key_stream, size_t key_length, size_t key_offset);
+
+/// <summary>
+/// repeat the key so a full vector register can be loaded starting at any offset within it
+/// </summary>
+/// 
+/// <param name="key">key to expand</param>
+/// 
+/// <returns>the key repeated out to key.length() + key_stream_padding bytes</returns>
+std::string expand_key_stream(const std::string& key)
+{
+    const auto key_length = key.length();
+    assert(key_length > 0);
+
+    std::string key_stream;
+    key_stream.reserve(key_length + key_stream_padding);
+
+    // keep appending whole copies of the key, then trim to the exact length
+    while (key_stream.length() < key_length + key_stream_padding)
+    {
+        key_stream += key;
+    }
+    key_stream.resize(key_length + key_stream_padding);
+
+    return key_stream;
+}
+
+/// <summary>
+/// the original one byte per iteration loop with a modulo per byte.
+/// kept as the reference every other kernel is verified and benchmarked against.
+/// </summary>
+static void xor_kernel_reference(const char* source, char* output, size_t length, const char* key_stream, size_t key_length, size_t key_offset)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        output[i] = source[i] ^ key_stream[(key_offset + i) % key_length];
+    }
+}
+
+/// <summary>
+/// portable one byte per iteration kernel, also used to finish the tail of the vector kernels
+/// </summary>
+static void xor_kernel_scalar(const char* source, char* output, size_t length, const char* key_stream, size_t key_length, size_t key_offset)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        output[i] = source[i] ^ key_stream[key_offset];
+
+        // wrap the key offset with a compare instead of a modulo per byte
+        if (++key_offset == key_length)
+        {
+            key_offset = 0;
+        }
+    }
+}
+
+#if defined(ENCRYPTION_HAS_SSE2)
+/// <summary>
+/// SSE2 kernel, 32 bytes per step using two 16 byte registers
+/// </summary>
+static void xor_kernel_sse2(const char* source, char* output, size_t length, const char* key_stream, size_t key_length, size_t key_offset)
+{
+    const size_t step = 32;
+    // how far the key offset moves each step, computed once so the loop has no division in it
+    const size_t offset_advance = step % key_length;
+
+    size_t i = 0;
+    for (; i + step <= length; i += step)
+    {
+        const __m128i key_low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key_stream + key_offset));
+        const __m128i key_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key_stream + key_offset + 16));
+        const __m128i data_low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i data_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 16));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_xor_si128(data_low, key_low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 16), _mm_xor_si128(data_high, key_high));
+
+        key_offset += offset_advance;
+        if (key_offset >= key_length)
+        {
+            key_offset -= key_length;
+        }
+    }
+
+    // finish whatever is left over that does not fill a full step
+    xor_kernel_scalar(source + i, output + i, length - i, key_stream, key_length, key_offset);
+}
+#endif
+
+#if defined(ENCRYPTION_HAS_AVX2)
+/// <summary>
+/// AVX2 kernel, 64 bytes per step using two 32 byte registers
+/// </summary>
+ENCRYPTION_TARGET_AVX2
+static void xor_kernel_avx2(const char* source, char* output, size_t length, const char* key_stream, size_t key_length, size_t key_offset)
+{
+    const size_t step = 64;
+    // how far the key offset moves each step, computed once so the loop has no division in it
+    const size_t offset_advance = step % key_length;
+
+    size_t i = 0;
+    for (; i + step <= length; i += step)
+    {
+        const __m256i key_low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key_stream + key_offset));
+        const __m256i key_high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key_stream + key_offset + 32));
+        const __m256i data_low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        const __m256i data_high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 32));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_xor_si256(data_low, key_low));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i + 32), _mm256_xor_si256(data_high, key_high));
+
+        key_offset += offset_advance;
+        if (key_offset >= key_length)
+        {
+            key_offset -= key_length;
+        }
+    }
+
+    // finish whatever is left over that does not fill a full step
+    xor_kernel_scalar(source + i, output + i, length - i, key_stream, key_length, key_offset);
+}
+
+/// <summary>
+/// ask the CPU (and OS, for the wider register state) whether AVX2 can be used
+/// </summary>
+static bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+    int registers[4];
+
+    __cpuid(registers, 0);
+    if (registers[0] < 7)
+    {
+        return false;
+    }
+
+    // AVX (bit 28) and OSXSAVE (bit 27), then make sure the OS saves the YMM registers
+    __cpuid(registers, 1);
+    const int avx_bits = (1 << 27) | (1 << 28);
+    if ((registers[2] & avx_bits) != avx_bits || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    // AVX2 is bit 5 of EBX on leaf 7
+    __cpuidex(registers, 7, 0);
+    return (registers[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+/// <summary>
+/// a kernel along with a printable name for it
+/// </summary>
+struct xor_kernel_info
+{
+    const char* name;
+    xor_kernel kernel;
+};
+
+/// <summary>
+/// pick the widest kernel this CPU supports. done once and then reused by every call.
+/// </summary>
+static const xor_kernel_info& active_xor_kernel()
+{
+    static const xor_kernel_info selected = []() -> xor_kernel_info
+    {
+#if defined(ENCRYPTION_HAS_AVX2)
+        if (cpu_supports_avx2())
+        {
+            return { "avx2", xor_kernel_avx2 };
+        }
+#endif
+#if defined(ENCRYPTION_HAS_SSE2)
+        return { "sse2", xor_kernel_sse2 };
+#else
+        return { "scalar", xor_kernel_scalar };
+#endif
+    }();
+
+    return selected;
+}
+
+/// <summary>
+/// everything encrypt_decrypt needs to know about a key, worked out once and reused for every payload encrypted with it.
+/// the key stream is repeated out to a whole number of 64 byte vector steps (the LCM of the key length and 64),
+/// so every vector step starts on an aligned position in the stream and the key offset moves the same way every step.
+/// the key and its stream are wiped when the context is destroyed.
+/// </summary>
+class key_context
+{
+public:
+    explicit key_context(const std::string& key) : key(key)
+    {
+        const auto key_length = key.length();
+        assert(key_length > 0);
+
+        // long keys would make the LCM huge, they just repeat once and use unaligned loads
+        const size_t lcm = key_length / std::gcd(key_length, vector_step) * vector_step;
+        stream_period = lcm <= max_aligned_period ? lcm : key_length;
+
+        // over-allocate so the stream itself can start on a cache line
+        storage.resize(stream_period + key_stream_padding + vector_step);
+        const auto address = reinterpret_cast<uintptr_t>(storage.data());
+        stream = storage.data() + (vector_step - address % vector_step) % vector_step;
+
+        for (size_t i = 0; i < stream_period + key_stream_padding; ++i)
+        {
+            stream[i] = key[i % key_length];
+        }
+    }
+
+    ~key_context()
+    {
+        // the key and the stream are both the secret, so overwrite them before the memory is handed back.
+        // volatile keeps the compiler from dropping stores to memory that is about to be freed.
+        volatile char* stream_bytes = storage.data();
+        for (size_t i = 0; i < storage.size(); ++i)
+        {
+            stream_bytes[i] = 0;
+        }
+
+        volatile char* key_bytes = key.data();
+        for (size_t i = 0; i < key.length(); ++i)
+        {
+            key_bytes[i] = 0;
+        }
+    }
+
+    key_context(const key_context&) = delete;
+    key_context& operator=(const key_context&) = delete;
+
+    /// <summary>
+    /// the key this context was built from
+    /// </summary>
+    const std::string& original_key() const { return key; }
+
+    /// <summary>
+    /// how many bytes before the key stream repeats, always a multiple of the key length
+    /// </summary>
+    size_t period() const { return stream_period; }
+
+    /// <summary>
+    /// encrypt or decrypt length bytes with the widest xor kernel this CPU supports
+    /// </summary>
+    /// 
+    /// <param name="source">input bytes to process</param>
+    /// <param name="output">where to write the transformed bytes (may be the same as source)</param>
+    /// <param name="length">number of bytes to process</param>
+    /// <param name="stream_offset">position in the key stream that lines up with source[0], less than period()</param>
+    /// 
+    /// <returns>the stream offset the byte after the last one processed lines up with</returns>
+    size_t transform(const char* source, char* output, size_t length, size_t stream_offset = 0) const
+    {
+        assert(stream_offset < stream_period);
+
+        active_xor_kernel().kernel(source, output, length, stream, stream_period, stream_offset);
+
+        return (stream_offset + length) % stream_period;
+    }
+
+private:
+    // bytes consumed per step by the widest kernel
+    static constexpr size_t vector_step = 64;
+    // above this an expanded stream stops fitting comfortably in L1
+    static constexpr size_t max_aligned_period = 16 * 1024;
+
+    std::string key;
+    std::vector<char> storage;
+    char* stream = nullptr;
+    size_t stream_period = 0;
+};
+
+/// <summary>
+/// compare two keys without stopping at the first byte that differs, so the time taken does not say how much of a key matched
+/// </summary>
+static bool keys_equal(const std::string& left, const std::string& right)
+{
+    if (left.length() != right.length())
+    {
+        return false;
+    }
+
+    unsigned char difference = 0;
+    for (size_t i = 0; i < left.length(); ++i)
+    {
+        difference |= static_cast<unsigned char>(left[i] ^ right[i]);
+    }
+    return difference == 0;
+}
+
+/// <summary>
+/// least recently used cache of key contexts, so encrypting with a key seen recently skips building its key stream.
+/// a cached key stays in memory until it is evicted and the last caller using it lets go; callers that do not want
+/// a key kept can build their own key_context and use the encrypt_decrypt overload that takes one.
+/// </summary>
+class key_context_cache
+{
+public:
+    explicit key_context_cache(size_t capacity) : capacity(capacity)
+    {
+        assert(capacity > 0);
+    }
+
+    /// <summary>
+    /// the context for a key, built and cached if it is not already.
+    /// this takes the cache's lock, so loops should get the context once and reuse it.
+    /// </summary>
+    std::shared_ptr<const key_context> get(const std::string& key)
+    {
+        const size_t hash = std::hash<std::string>{}(key);
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // the map is keyed by hash, so only keys that collide are compared, and those in constant time
+        const auto candidates = index.equal_range(hash);
+        for (auto found = candidates.first; found != candidates.second; ++found)
+        {
+            if (keys_equal((*found->second)->original_key(), key))
+            {
+                // move it to the front, it is now the most recently used
+                recent.splice(recent.begin(), recent, found->second);
+                return *found->second;
+            }
+        }
+
+        recent.push_front(std::make_shared<const key_context>(key));
+        index.emplace(hash, recent.begin());
+
+        // drop the least recently used context, anyone still using it keeps their own reference
+        if (recent.size() > capacity)
+        {
+            const auto oldest = std::prev(recent.end());
+            const auto entries = index.equal_range(std::hash<std::string>{}((*oldest)->original_key()));
+            for (auto entry = entries.first; entry != entries.second; ++entry)
+            {
+                if (entry->second == oldest)
+                {
+                    index.erase(entry);
+                    break;
+                }
+            }
+            recent.pop_back();
+        }
+
+        return recent.front();
+    }
+
+private:
+    const size_t capacity;
+    std::list<std::shared_ptr<const key_context>> recent;
+    std::unordered_multimap<size_t, std::list<std::shared_ptr<const key_context>>::iterator> index;
+    std::mutex mutex;
+};
+
+/// <summary>
+/// the key contexts shared by every encrypt_decrypt call
+/// </summary>
+key_context_cache& shared_key_contexts()
+{
+    static key_context_cache cache(64);
+    return cache;
+}
+
+/// <summary>
+/// encrypt or decrypt source into a caller-owned output buffer with a key context the caller already holds.
+/// nothing is looked up, so this is the overload for hot loops, and for keys that should not go into the shared cache.
+/// </summary>
+/// 
+/// <param name="source">input bytes to process</param>
+/// <param name="output">buffer to write the transformed bytes to, must be the same size as source (may alias source)</param>
+/// <param name="context">key to use in encryption / decryption</param>
+void encrypt_decrypt(std::span<const char> source, std::span<char> output, const key_context& context)
+{
+    assert(source.size() > 0);
+    assert(output.size() == source.size());
+
+    context.transform(source.data(), output.data(), source.size());
+}
+
+/// <summary>
+/// encrypt or decrypt source into a caller-owned output buffer using the provided key
+/// </summary>
+/// 
+/// <param name="source">input bytes to process</param>
+/// <param name="output">buffer to write the transformed bytes to, must be the same size as source (may alias source)</param>
+/// <param name="key">key to use in encryption / decryption</param>
+void encrypt_decrypt(std::span<const char> source, std::span<char> output, const std::string& key)
+{
+    // get lengths now instead of calling the function every time.
+    // this would have most likely been inlined by the compiler, but design for perfomance.
+    const auto source_length = source.size();
+
+    // assert that our input data is good
+    assert(!key.empty());
+    assert(source_length > 0);
+
+    // our output length must equal our source length
+    assert(output.size() == source_length);
+
+    // transform the whole buffer with the widest xor kernel this CPU supports.
+    // the kernel walks a pre-expanded key stream, cached per key, instead of taking a mod per character.
+    encrypt_decrypt(source, output, *shared_key_contexts().get(key));
+}
+
+/// <summary>
+/// encrypt or decrypt a buffer in place using the provided key
+/// </summary>
+/// 
+/// <param name="data">bytes to transform, overwritten with the result</param>
+/// <param name="key">key to use in encryption / decryption</param>
+void encrypt_decrypt(std::span<char> data, const std::string& key)
+{
+    encrypt_decrypt(std::span<const char>(data), data, key);
+}
+
 /// <summary>
 /// encrypt or decrypt a source string using the provided key
 /// </summary>
@@ -18,43 +502,233 @@
 /// <returns>transformed string</returns>
 std::string encrypt_decrypt(const std::string& source, const std::string& key)
 {
-    // get lengths now instead of calling the function every time.
-    // this would have most likely been inlined by the compiler, but design for perfomance.
-    const auto key_length = key.length();
-    const auto source_length = source.length();
+    // size the output without copying source into it, the kernel writes every byte
+    std::string output(source.length(), '\0');
+
+    encrypt_decrypt(std::span<const char>(source), std::span<char>(output), key);
+
+    // return the transformed string
+    return output;
+}
+
+/// <summary>
+/// a fixed set of worker threads that run parallel loops together with the calling thread
+/// </summary>
+class thread_pool
+{
+public:
+    /// <summary>
+    /// start the pool
+    /// </summary>
+    /// <param name="thread_count">total threads used by parallel_for, including the caller. 0 uses every hardware thread.</param>
+    explicit thread_pool(unsigned thread_count = 0)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // the calling thread does its share of the work, so it needs one less worker
+        for (unsigned i = 1; i < thread_count; ++i)
+        {
+            workers.emplace_back(&thread_pool::worker_loop, this);
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_ready.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    /// <summary>
+    /// number of threads parallel_for runs on, including the caller
+    /// </summary>
+    size_t size() const { return workers.size() + 1; }
+
+    /// <summary>
+    /// call task(0) .. task(task_count - 1) spread across the pool, returning once every call has finished.
+    /// only one parallel_for may run on a pool at a time.
+    /// </summary>
+    void parallel_for(size_t task_count, const std::function<void(size_t)>& task)
+    {
+        // nothing to share out, so skip waking the workers
+        if (workers.empty() || task_count <= 1)
+        {
+            for (size_t index = 0; index < task_count; ++index)
+            {
+                task(index);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current_task = &task;
+            total_tasks = task_count;
+            next_task = 0;
+            busy_workers = workers.size();
+            ++generation;
+        }
+        work_ready.notify_all();
+
+        run_tasks();
+
+        // wait for the workers to finish whatever tasks they claimed
+        std::unique_lock<std::mutex> lock(mutex);
+        work_done.wait(lock, [this] { return busy_workers == 0; });
+        current_task = nullptr;
+    }
+
+private:
+    void worker_loop()
+    {
+        unsigned long long seen_generation = 0;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping)
+            {
+                return;
+            }
+            seen_generation = generation;
+
+            lock.unlock();
+            run_tasks();
+            lock.lock();
+
+            if (--busy_workers == 0)
+            {
+                work_done.notify_one();
+            }
+        }
+    }
+
+    // claim tasks one at a time until none are left
+    void run_tasks()
+    {
+        for (size_t index = next_task.fetch_add(1); index < total_tasks; index = next_task.fetch_add(1))
+        {
+            (*current_task)(index);
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+
+    const std::function<void(size_t)>* current_task = nullptr;
+    size_t total_tasks = 0;
+    std::atomic<size_t> next_task{ 0 };
+    size_t busy_workers = 0;
+    unsigned long long generation = 0;
+    bool stopping = false;
+};
+
+/// <summary>
+/// encrypt or decrypt source into a caller-owned output buffer, splitting the work across a thread pool
+/// </summary>
+/// 
+/// <param name="source">input bytes to process</param>
+/// <param name="output">buffer to write the transformed bytes to, must be the same size as source (may alias source)</param>
+/// <param name="key">key to use in encryption / decryption</param>
+/// <param name="pool">threads to run the transform on</param>
+void encrypt_decrypt(std::span<const char> source, std::span<char> output, const std::string& key, thread_pool& pool)
+{
+    const auto source_length = source.size();
 
     // assert that our input data is good
-    assert(key_length > 0);
+    assert(!key.empty());
     assert(source_length > 0);
+    assert(output.size() == source_length);
+
+    // below this a chunk is not worth handing to another thread
+    const size_t min_chunk_length = 256 * 1024;
+    // chunk boundaries land on cache lines so no two threads ever write the same line
+    const size_t cache_line = 64;
 
-    std::string output = source;
+    // a few chunks per thread so a thread that gets descheduled does not hold everyone up
+    const size_t chunks_wanted = pool.size() * 4;
+    const size_t chunk_length = std::max(min_chunk_length, (source_length + chunks_wanted - 1) / chunks_wanted);
+    const size_t chunk_count = (source_length + chunk_length - 1) / chunk_length;
 
-    // loop through the source string char by char
-    for (size_t i = 0; i < source_length; ++i)
+    const auto output_address = reinterpret_cast<uintptr_t>(output.data());
+
+    // where a chunk starts, moved back to the start of the output cache line it falls in
+    auto chunk_start = [&](size_t chunk) -> size_t
     {
-      // transform each character based on an xor of the key modded constrained to key length using a mod
-		output[i] = source[i] ^ key[i % key_length];
-    }
+        if (chunk == 0)
+        {
+            return 0;
+        }
+        if (chunk >= chunk_count)
+        {
+            return source_length;
+        }
 
-    // our output length must equal our source length
-    assert(output.length() == source_length);
+        const size_t start = chunk * chunk_length;
+        return start - (output_address + start) % cache_line;
+    };
 
-    // return the transformed string
-    return output;
+    // looked up once for the whole call, the workers share it without touching the cache's lock
+    const auto context = shared_key_contexts().get(key);
+
+    pool.parallel_for(chunk_count, [&](size_t chunk)
+    {
+        const size_t start = chunk_start(chunk);
+        const size_t end = chunk_start(chunk + 1);
+
+        // each chunk picks the key up wherever its first byte falls in the key stream
+        context->transform(source.data() + start, output.data() + start, end - start, start % context->period());
+    });
+}
+
+// what read_file hands back when the input file cannot be opened
+const std::string default_file_text = "John Q. Smith\nThis is my test string";
+
+// how much of a file the streaming functions hold in memory at once
+constexpr size_t stream_chunk_size = 1024 * 1024;
+
+/// <summary>
+/// encrypt or decrypt one chunk of a longer stream in place, continuing from where the previous chunk left off in the key
+/// </summary>
+/// 
+/// <param name="chunk">bytes to transform, overwritten with the result</param>
+/// <param name="context">key to use in encryption / decryption</param>
+/// <param name="stream_offset">position in the key stream that lines up with the first byte of the chunk</param>
+/// 
+/// <returns>the key stream offset the next chunk starts at</returns>
+size_t encrypt_decrypt_chunk(std::span<char> chunk, const key_context& context, size_t stream_offset)
+{
+    return context.transform(chunk.data(), chunk.data(), chunk.size(), stream_offset);
 }
 
 std::string read_file(const std::string& filename)
 {
     std::string file_text;
 
-    // Open the file
-    std::ifstream file(filename);
+    // Open the file, in binary so no platform rewrites its line endings on the way in
+    std::ifstream file(filename, std::ios::binary);
 
     // Check for successful file opening
     if (!file.is_open()) {
         std::cerr << "Error opening file: " << filename << std::endl;
 
-        return "John Q. Smith\nThis is my test string";  // Return default string if file fails to open
+        return default_file_text;  // Return default string if file fails to open
     }
 
     // Use a loop + getline() to read each line from the file and append it to file_text
@@ -84,44 +758,1615 @@ std::string get_student_name(const std::string& string_data)
     return student_name;
 }
 
-void save_data_file(const std::string& filename, const std::string& student_name, const std::string& key, const std::string& data)
+/// <summary>
+/// convert a time to local calendar time on any platform
+/// </summary>
+/// 
+/// <param name="timestamp">time to convert</param>
+/// <param name="time_info">receives the local calendar time</param>
+/// 
+/// <returns>false if the time could not be converted</returns>
+static bool to_local_time(time_t timestamp, struct tm& time_info)
+{
+#if defined(_MSC_VER)
+    return localtime_s(&time_info, &timestamp) == 0;
+#else
+    return localtime_r(&timestamp, &time_info) != nullptr;
+#endif
+}
+
+/// <summary>
+/// today's date, cached until local midnight. readers never take a lock: the fields are guarded by a
+/// sequence number that is odd while the date is being replaced, and a reader that sees it change retries.
+/// </summary>
+class date_cache
 {
-    //  Open the file
-    std::ofstream file(filename);
+public:
+    /// <summary>
+    /// the local date of a timestamp as yyyy-mm-dd
+    /// </summary>
+    std::string format(time_t timestamp)
+    {
+        for (;;)
+        {
+            const auto start_sequence = sequence.load(std::memory_order_acquire);
+            const auto from = valid_from.load(std::memory_order_relaxed);
+            const auto until = valid_until.load(std::memory_order_relaxed);
+            const auto date = packed_date.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
 
-    // Check for successful file opening
-    if (!file.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
+            // someone replaced the date while we read it, try again
+            if ((start_sequence & 1) != 0 || sequence.load(std::memory_order_relaxed) != start_sequence)
+            {
+                continue;
+            }
 
-		return;  // Exit the function if file opening fails
+            if (timestamp >= from && timestamp < until)
+            {
+                return unpack(date);
+            }
+
+            return refresh(timestamp);
+        }
     }
 
-    //  Line 1: student name
-    file << student_name << std::endl;
+private:
+    // work out the date and the local day it covers, then publish them for everyone else
+    std::string refresh(time_t timestamp)
+    {
+        struct tm time_info;
+        if (!to_local_time(timestamp, time_info))
+        {
+            return "0000-00-00";
+        }
+        const auto date = static_cast<int64_t>((time_info.tm_year + 1900) * 10000 + (time_info.tm_mon + 1) * 100 + time_info.tm_mday);
 
-    //  Line 2: timestamp (yyyy-mm-dd)
-    time_t timestamp = time(nullptr);
-    struct tm time_info;
-    localtime_s(&time_info, &timestamp);
+        // mktime works out midnight at both ends of the day, including days that daylight saving makes longer or shorter
+        struct tm day_boundary = time_info;
+        day_boundary.tm_hour = 0;
+        day_boundary.tm_min = 0;
+        day_boundary.tm_sec = 0;
+        day_boundary.tm_isdst = -1;
+        const time_t day_start = mktime(&day_boundary);
 
-    file << std::put_time(&time_info, "%Y-%m-%d") << std::endl;
+        day_boundary = time_info;
+        day_boundary.tm_mday += 1;
+        day_boundary.tm_hour = 0;
+        day_boundary.tm_min = 0;
+        day_boundary.tm_sec = 0;
+        day_boundary.tm_isdst = -1;
+        const time_t day_end = mktime(&day_boundary);
 
-    //  Line 3: key used
-    file << key << std::endl;
+        // only one thread replaces the date at a time, and only once a day
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        const auto current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
 
-    //  Line 4+: data
-    file << data << std::endl;  // Since multi-lined data is handled in read_file(), it's fine to use one line here
+        valid_from.store(day_start, std::memory_order_relaxed);
+        valid_until.store(day_end, std::memory_order_relaxed);
+        packed_date.store(date, std::memory_order_relaxed);
 
-    // Close the file
-    file.close();
+        sequence.store(current + 2, std::memory_order_release);
 
-}
+        return unpack(date);
+    }
 
-int main()
-{
-    std::cout << "Encyption Decryption Test!" << std::endl;
+    // yyyymmdd as an integer to yyyy-mm-dd as text
+    static std::string unpack(int64_t date)
+    {
+        std::string text = "0000-00-00";
+        const int digits[] = { 0, 1, 2, 3, 5, 6, 8, 9 };
+        for (int i = 7; i >= 0; --i)
+        {
+            text[digits[i]] = static_cast<char>('0' + date % 10);
+            date /= 10;
+        }
+        return text;
+    }
 
-    // Input file format:
+    std::atomic<unsigned long long> sequence{ 0 };
+    std::atomic<time_t> valid_from{ 0 };
+    std::atomic<time_t> valid_until{ 0 };
+    std::atomic<int64_t> packed_date{ 0 };
+    std::mutex writer_mutex;
+};
+
+/// <summary>
+/// today's local date as yyyy-mm-dd, only reformatted when the day changes
+/// </summary>
+std::string current_date_string()
+{
+    static date_cache cache;
+    return cache.format(time(nullptr));
+}
+
+/// <summary>
+/// write the three line header that starts every data file
+/// </summary>
+/// 
+/// <param name="file">stream to write the header to</param>
+/// <param name="student_name">line 1 of the header</param>
+/// <param name="key">line 3 of the header, line 2 is today's date</param>
+void write_data_file_header(std::ostream& file, const std::string& student_name, const std::string& key)
+{
+    // the header is small, so let the data that follows decide when the stream gets flushed
+    //  Line 1: student name
+    file << student_name << '\n';
+
+    //  Line 2: timestamp (yyyy-mm-dd)
+    file << current_date_string() << '\n';
+
+    //  Line 3: key used
+    file << key << '\n';
+}
+
+bool save_data_file(const std::string& filename, const std::string& student_name, const std::string& key, const std::string& data)
+{
+    //  Open the file. every data file reader and writer uses binary mode, so a header line is the same bytes on every platform
+    std::ofstream file(filename, std::ios::binary);
+
+    // Check for successful file opening
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+
+		return false;  // Exit the function if file opening fails
+    }
+
+    //  Lines 1-3: student name, timestamp, key used
+    write_data_file_header(file, student_name, key);
+
+    //  Line 4+: data
+    file << data << std::endl;  // Since multi-lined data is handled in read_file(), it's fine to use one line here
+
+    // Close the file
+    file.close();
+
+    // a full disk or a failed flush shows up as a failed stream
+    if (!file) {
+        std::cerr << "Error writing file: " << filename << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+/// <summary>
+/// encrypt or decrypt a file into a data file one chunk at a time, so memory use does not grow with the file.
+/// the output is byte for byte what save_data_file(output, get_student_name(read_file(input)), key, encrypt_decrypt(read_file(input), key)) writes.
+/// </summary>
+/// 
+/// <param name="input_filename">file to read, read_file's default string is used if it cannot be opened</param>
+/// <param name="output_filename">data file to write</param>
+/// <param name="key">key to use in encryption / decryption</param>
+/// <param name="chunk_size">how many bytes to read, transform and write at a time</param>
+/// 
+/// <returns>true if the output file was written</returns>
+bool encrypt_file_streaming(const std::string& input_filename, const std::string& output_filename, const std::string& key, size_t chunk_size = stream_chunk_size)
+{
+    assert(key.length() > 0);
+    assert(chunk_size > 0);
+
+    std::ifstream file(input_filename, std::ios::binary);
+    std::istringstream default_text;
+    std::istream* input = &file;
+
+    // read_file only terminates the last line with a newline when the text came from a real file
+    const bool file_opened = file.is_open();
+    if (!file_opened) {
+        std::cerr << "Error opening file: " << input_filename << std::endl;
+
+        default_text.str(default_file_text);  // Use the same default string as read_file
+        input = &default_text;
+    }
+
+    std::vector<char> chunk(chunk_size);
+
+    // the header needs the student name, so keep reading until the first line is complete.
+    // this is the only data held beyond a single chunk.
+    std::string first_line;
+    size_t newline = std::string::npos;
+    while ((newline = first_line.find('\n')) == std::string::npos)
+    {
+        input->read(chunk.data(), chunk.size());
+        const auto count = static_cast<size_t>(input->gcount());
+        if (count == 0)
+        {
+            break;
+        }
+        first_line.append(chunk.data(), count);
+    }
+
+    // same rules as get_student_name, with the newline read_file would have appended to an unterminated file
+    std::string student_name;
+    if (newline != std::string::npos)
+    {
+        student_name = first_line.substr(0, newline);
+    }
+    else if (file_opened)
+    {
+        student_name = first_line;
+    }
+
+    std::ofstream output(output_filename, std::ios::binary);
+    if (!output.is_open()) {
+        std::cerr << "Error opening file: " << output_filename << std::endl;
+
+        return false;
+    }
+
+    write_data_file_header(output, student_name, key);
+
+    const auto context = shared_key_contexts().get(key);
+    size_t stream_offset = 0;
+    char last_char = '\n';
+
+    // transform a chunk and write it out, carrying the key offset over to the next chunk
+    auto write_chunk = [&](std::span<char> data)
+    {
+        if (data.empty())
+        {
+            return;
+        }
+        last_char = data.back();
+        stream_offset = encrypt_decrypt_chunk(data, *context, stream_offset);
+        output.write(data.data(), data.size());
+    };
+
+    write_chunk(std::span<char>(first_line));
+
+    while (*input)
+    {
+        input->read(chunk.data(), chunk.size());
+        write_chunk(std::span<char>(chunk.data(), static_cast<size_t>(input->gcount())));
+    }
+
+    // read_file ends every line it reads with a newline, including a last line that had none in the file
+    if (file_opened && last_char != '\n')
+    {
+        char newline_char = '\n';
+        write_chunk(std::span<char>(&newline_char, 1));
+    }
+
+    // save_data_file ends the data with one more newline
+    output << std::endl;
+
+    return static_cast<bool>(output);
+}
+
+/// <summary>
+/// decrypt (or re-encrypt) the data in a data file one chunk at a time, writing a new data file with the same name and key.
+/// the output is byte for byte what save_data_file writes for the transformed in-memory data.
+/// </summary>
+/// 
+/// <param name="input_filename">data file written by save_data_file or encrypt_file_streaming</param>
+/// <param name="output_filename">data file to write</param>
+/// <param name="chunk_size">how many bytes to read, transform and write at a time</param>
+/// 
+/// <returns>true if the output file was written</returns>
+bool decrypt_file_streaming(const std::string& input_filename, const std::string& output_filename, size_t chunk_size = stream_chunk_size)
+{
+    assert(chunk_size > 0);
+
+    std::ifstream input(input_filename, std::ios::binary);
+    if (!input.is_open()) {
+        std::cerr << "Error opening file: " << input_filename << std::endl;
+
+        return false;
+    }
+
+    // Lines 1-3: student name, timestamp, key used
+    std::string student_name;
+    std::string timestamp;
+    std::string key;
+    if (!std::getline(input, student_name) || !std::getline(input, timestamp) || !std::getline(input, key) || key.empty()) {
+        std::cerr << "Not a valid data file: " << input_filename << std::endl;
+
+        return false;
+    }
+
+    // the data runs from here up to the newline save_data_file ends the file with
+    const auto data_start = input.tellg();
+    input.seekg(0, std::ios::end);
+    const auto file_end = input.tellg();
+    input.seekg(data_start);
+
+    if (file_end - data_start < 1) {
+        std::cerr << "Not a valid data file: " << input_filename << std::endl;
+
+        return false;
+    }
+    auto remaining = static_cast<size_t>(file_end - data_start) - 1;
+
+    std::ofstream output(output_filename, std::ios::binary);
+    if (!output.is_open()) {
+        std::cerr << "Error opening file: " << output_filename << std::endl;
+
+        return false;
+    }
+
+    write_data_file_header(output, student_name, key);
+
+    const auto context = shared_key_contexts().get(key);
+    size_t stream_offset = 0;
+    std::vector<char> chunk(chunk_size);
+
+    while (remaining > 0 && input)
+    {
+        input.read(chunk.data(), std::min(remaining, chunk.size()));
+        const auto count = static_cast<size_t>(input.gcount());
+
+        stream_offset = encrypt_decrypt_chunk(std::span<char>(chunk.data(), count), *context, stream_offset);
+        output.write(chunk.data(), count);
+        remaining -= count;
+    }
+
+    output << std::endl;
+
+    return remaining == 0 && static_cast<bool>(output);
+}
+
+#if defined(ENCRYPTION_HAS_MMAP)
+/// <summary>
+/// a whole file mapped into memory, unmapped and closed when destroyed
+/// </summary>
+class mapped_file
+{
+public:
+    mapped_file() = default;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file()
+    {
+        if (address != nullptr)
+        {
+            munmap(address, length);
+        }
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+    }
+
+    /// <summary>
+    /// map an existing file read-only
+    /// </summary>
+    /// <returns>false if the file cannot be opened, is not a regular file, or is empty</returns>
+    bool open_read(const std::string& filename)
+    {
+        // pipes, devices and empty files cannot be mapped. they are turned away before being opened, as opening a pipe
+        // waits for a writer, and the caller falls back to reading it as a stream, which opens it again.
+        struct stat file_status;
+        if (stat(filename.c_str(), &file_status) != 0 || !S_ISREG(file_status.st_mode) || file_status.st_size <= 0)
+        {
+            return false;
+        }
+
+        descriptor = open(filename.c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            return false;
+        }
+
+        // the path could have been replaced in between, so check what was actually opened
+        if (fstat(descriptor, &file_status) != 0 || !S_ISREG(file_status.st_mode) || file_status.st_size <= 0)
+        {
+            close(descriptor);
+            descriptor = -1;
+            return false;
+        }
+
+        return map(static_cast<size_t>(file_status.st_size), PROT_READ);
+    }
+
+    /// <summary>
+    /// create (or truncate) a file, size it with ftruncate and map it read-write
+    /// </summary>
+    /// <returns>false if the file cannot be created, sized or mapped</returns>
+    bool create(const std::string& filename, size_t size)
+    {
+        descriptor = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+        if (descriptor < 0 || size == 0 || ftruncate(descriptor, static_cast<off_t>(size)) != 0)
+        {
+            return false;
+        }
+
+        return map(size, PROT_READ | PROT_WRITE);
+    }
+
+    char* data() const { return address; }
+    size_t size() const { return length; }
+
+private:
+    bool map(size_t size, int protection)
+    {
+        void* mapping = mmap(nullptr, size, protection, MAP_SHARED, descriptor, 0);
+        if (mapping == MAP_FAILED)
+        {
+            return false;
+        }
+
+        address = static_cast<char*>(mapping);
+        length = size;
+
+        // both files are walked front to back exactly once
+        madvise(address, length, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    int descriptor = -1;
+    char* address = nullptr;
+    size_t length = 0;
+};
+
+/// <summary>
+/// write a data file by mapping it and transforming the data straight from the source mapping into it
+/// </summary>
+/// 
+/// <param name="output_filename">data file to write</param>
+/// <param name="student_name">line 1 of the header</param>
+/// <param name="key">key for the header and the transform</param>
+/// <param name="data">source bytes to transform, usually a mapping of the input file</param>
+/// <param name="append_newline">also transform a newline after data, as read_file adds to an unterminated last line</param>
+/// 
+/// <returns>true if the output file was written</returns>
+static bool write_data_file_mapped(const std::string& output_filename, const std::string& student_name, const std::string& key, std::span<const char> data, bool append_newline)
+{
+    // the header is only three short lines, format it the same way save_data_file does
+    std::ostringstream header_stream;
+    write_data_file_header(header_stream, student_name, key);
+    const std::string header = header_stream.str();
+
+    const size_t data_length = data.size() + (append_newline ? 1 : 0);
+
+    // header, data, and the newline save_data_file ends the file with
+    mapped_file output;
+    if (!output.create(output_filename, header.length() + data_length + 1))
+    {
+        std::cerr << "Error opening file: " << output_filename << std::endl;
+
+        return false;
+    }
+
+    char* destination = output.data();
+    std::memcpy(destination, header.data(), header.length());
+    destination += header.length();
+
+    const auto context = shared_key_contexts().get(key);
+    const size_t stream_offset = context->transform(data.data(), destination, data.size());
+    destination += data.size();
+
+    if (append_newline)
+    {
+        const char newline_char = '\n';
+        context->transform(&newline_char, destination++, 1, stream_offset);
+    }
+    *destination = '\n';
+
+    return true;
+}
+#endif
+
+/// <summary>
+/// encrypt or decrypt a file into a data file by memory mapping both files, with no intermediate copies of the data.
+/// the output matches encrypt_file_streaming, which is used instead when the input cannot be mapped (pipes, empty files, other platforms).
+/// </summary>
+/// 
+/// <param name="input_filename">file to read</param>
+/// <param name="output_filename">data file to write</param>
+/// <param name="key">key to use in encryption / decryption</param>
+/// 
+/// <returns>true if the output file was written</returns>
+bool encrypt_file_mapped(const std::string& input_filename, const std::string& output_filename, const std::string& key)
+{
+    assert(key.length() > 0);
+
+#if defined(ENCRYPTION_HAS_MMAP)
+    mapped_file input;
+    if (input.open_read(input_filename))
+    {
+        const std::span<const char> data(input.data(), input.size());
+
+        // same rules as get_student_name, with the newline read_file would have appended to an unterminated file
+        const auto newline = static_cast<const char*>(std::memchr(data.data(), '\n', data.size()));
+        const std::string student_name = newline != nullptr ? std::string(data.data(), newline) : std::string(data.data(), data.size());
+
+        return write_data_file_mapped(output_filename, student_name, key, data, data.back() != '\n');
+    }
+#endif
+
+    // fall back to the buffered path for anything that could not be mapped
+    return encrypt_file_streaming(input_filename, output_filename, key);
+}
+
+/// <summary>
+/// decrypt (or re-encrypt) the data in a data file by memory mapping it and the output file.
+/// the output matches decrypt_file_streaming, which is used instead when the input cannot be mapped.
+/// </summary>
+/// 
+/// <param name="input_filename">data file written by save_data_file or one of the file encryption functions</param>
+/// <param name="output_filename">data file to write</param>
+/// 
+/// <returns>true if the output file was written</returns>
+bool decrypt_file_mapped(const std::string& input_filename, const std::string& output_filename)
+{
+#if defined(ENCRYPTION_HAS_MMAP)
+    mapped_file input;
+    if (input.open_read(input_filename))
+    {
+        // Lines 1-3: student name, timestamp, key used
+        const char* position = input.data();
+        const char* const end = input.data() + input.size();
+        std::string header_lines[3];
+        bool valid = true;
+
+        for (auto& line : header_lines)
+        {
+            const auto newline = static_cast<const char*>(std::memchr(position, '\n', end - position));
+            if (newline == nullptr)
+            {
+                valid = false;
+                break;
+            }
+            line.assign(position, newline);
+            position = newline + 1;
+        }
+
+        // the data runs from here up to the newline save_data_file ends the file with
+        if (valid && !header_lines[2].empty() && position < end)
+        {
+            const std::span<const char> data(position, static_cast<size_t>(end - position) - 1);
+            return write_data_file_mapped(output_filename, header_lines[0], header_lines[2], data, false);
+        }
+    }
+#endif
+
+    // fall back to the buffered path, which also reports files that are not valid data files
+    return decrypt_file_streaming(input_filename, output_filename);
+}
+
+// Binary container layout, all integers little endian:
+//   0  char[8]  magic "CS405ENC"
+//   8  uint16   version
+//  10  uint16   flags (container_flag_checksum)
+//  12  uint32   payload offset from the start of the file
+//  16  uint64   payload length
+//  24  uint32   CRC-32 of the payload, 0 when there is no checksum
+//  28  uint32   reserved, 0
+//  32  uint32 length + bytes, for each of: student name, timestamp, key
+//      zero padding up to the payload offset, which is a multiple of 64 so the payload can be mapped and vector loaded
+const char container_magic[8] = { 'C', 'S', '4', '0', '5', 'E', 'N', 'C' };
+constexpr uint16_t container_version = 1;
+constexpr uint16_t container_flag_checksum = 0x0001;
+constexpr size_t container_preamble_size = 32;
+constexpr size_t container_payload_alignment = 64;
+
+/// <summary>
+/// everything in a container ahead of the payload
+/// </summary>
+struct container_header
+{
+    std::string student_name;
+    std::string timestamp;
+    std::string key;
+    uint64_t payload_offset = 0;
+    uint64_t payload_length = 0;
+    uint32_t checksum = 0;
+    bool has_checksum = false;
+};
+
+/// <summary>
+/// standard CRC-32 (the zip / ethernet polynomial) of a block of bytes
+/// </summary>
+uint32_t crc32(std::span<const char> data)
+{
+    static const auto table = []
+    {
+        std::vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (const char c : data)
+    {
+        crc = table[(crc ^ static_cast<unsigned char>(c)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// append an integer to a buffer as little endian bytes
+static void append_little_endian(std::string& buffer, uint64_t value, size_t byte_count)
+{
+    for (size_t i = 0; i < byte_count; ++i)
+    {
+        buffer += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+// read a little endian integer from a buffer
+static uint64_t read_little_endian(const char* buffer, size_t byte_count)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < byte_count; ++i)
+    {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+    }
+    return value;
+}
+
+/// <summary>
+/// build the container header for a payload
+/// </summary>
+/// 
+/// <param name="header">fields to write, payload_offset is filled in here</param>
+/// 
+/// <returns>the header bytes, padded out to the payload offset</returns>
+std::string build_container_header(container_header& header)
+{
+    std::string bytes(container_magic, sizeof(container_magic));
+    append_little_endian(bytes, container_version, 2);
+    append_little_endian(bytes, header.has_checksum ? container_flag_checksum : 0, 2);
+
+    // the payload offset is not known until the fields are laid out, patched below
+    append_little_endian(bytes, 0, 4);
+    append_little_endian(bytes, header.payload_length, 8);
+    append_little_endian(bytes, header.has_checksum ? header.checksum : 0, 4);
+    append_little_endian(bytes, 0, 4);
+
+    for (const std::string* field : { &header.student_name, &header.timestamp, &header.key })
+    {
+        append_little_endian(bytes, field->length(), 4);
+        bytes += *field;
+    }
+
+    // pad so the payload starts on an aligned offset
+    bytes.resize((bytes.length() + container_payload_alignment - 1) / container_payload_alignment * container_payload_alignment, '\0');
+
+    header.payload_offset = bytes.length();
+    for (size_t i = 0; i < 4; ++i)
+    {
+        bytes[12 + i] = static_cast<char>((header.payload_offset >> (8 * i)) & 0xFF);
+    }
+
+    return bytes;
+}
+
+/// <summary>
+/// read the fixed size preamble at the start of a container
+/// </summary>
+/// 
+/// <param name="preamble">the first container_preamble_size bytes of the file</param>
+/// <param name="header">receives the offsets, lengths and checksum</param>
+/// 
+/// <returns>false if this is not a container this version can read</returns>
+static bool parse_container_preamble(const char* preamble, container_header& header)
+{
+    if (std::memcmp(preamble, container_magic, sizeof(container_magic)) != 0 || read_little_endian(preamble + 8, 2) != container_version)
+    {
+        return false;
+    }
+
+    header.has_checksum = (read_little_endian(preamble + 10, 2) & container_flag_checksum) != 0;
+    header.payload_offset = read_little_endian(preamble + 12, 4);
+    header.payload_length = read_little_endian(preamble + 16, 8);
+    header.checksum = static_cast<uint32_t>(read_little_endian(preamble + 24, 4));
+
+    return header.payload_offset >= container_preamble_size;
+}
+
+/// <summary>
+/// read the length prefixed fields that follow the preamble
+/// </summary>
+/// 
+/// <param name="fields">bytes from the end of the preamble up to the payload offset</param>
+/// <param name="header">receives the student name, timestamp and key</param>
+/// 
+/// <returns>false if a field runs past the payload</returns>
+static bool parse_container_fields(std::span<const char> fields, container_header& header)
+{
+    size_t position = 0;
+    for (std::string* field : { &header.student_name, &header.timestamp, &header.key })
+    {
+        if (fields.size() - position < 4)
+        {
+            return false;
+        }
+        const auto length = static_cast<size_t>(read_little_endian(fields.data() + position, 4));
+        position += 4;
+
+        if (fields.size() - position < length)
+        {
+            return false;
+        }
+        field->assign(fields.data() + position, length);
+        position += length;
+    }
+
+    return true;
+}
+
+/// <summary>
+/// write a payload (normally already encrypted) into a binary container file
+/// </summary>
+/// 
+/// <param name="filename">container file to write</param>
+/// <param name="student_name">student name field</param>
+/// <param name="timestamp">timestamp field (yyyy-mm-dd)</param>
+/// <param name="key">key field</param>
+/// <param name="payload">bytes to store</param>
+/// <param name="with_checksum">store a CRC-32 of the payload for readers to verify</param>
+/// 
+/// <returns>true if the file was written</returns>
+bool save_container_file(const std::string& filename, const std::string& student_name, const std::string& timestamp, const std::string& key, std::span<const char> payload, bool with_checksum)
+{
+    container_header header;
+    header.student_name = student_name;
+    header.timestamp = timestamp;
+    header.key = key;
+    header.payload_length = payload.size();
+    header.has_checksum = with_checksum;
+    header.checksum = with_checksum ? crc32(payload) : 0;
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+
+        return false;
+    }
+
+    const std::string header_bytes = build_container_header(header);
+    file.write(header_bytes.data(), header_bytes.size());
+    file.write(payload.data(), payload.size());
+
+    return static_cast<bool>(file);
+}
+
+/// <summary>
+/// read length bytes from a stream into text, a block at a time so a length that is larger than the stream
+/// only costs memory for what the stream holds
+/// </summary>
+/// <returns>false if the stream ends first</returns>
+static bool read_exactly(std::istream& stream, std::string& text, uint64_t length)
+{
+    const size_t block_size = 1 << 20;
+
+    text.clear();
+    while (text.size() < length)
+    {
+        const size_t block = static_cast<size_t>(std::min<uint64_t>(block_size, length - text.size()));
+        const size_t filled = text.size();
+        text.resize(filled + block);
+        if (!stream.read(&text[filled], static_cast<std::streamsize>(block)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// read a binary container file. the payload is found from the preamble, nothing is scanned for.
+/// </summary>
+/// 
+/// <param name="filename">container file to read</param>
+/// <param name="header">receives the header fields</param>
+/// <param name="payload">receives the payload</param>
+/// 
+/// <returns>false if the file cannot be read, is not a container, or fails its checksum</returns>
+bool read_container_file(const std::string& filename, container_header& header, std::string& payload)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+
+        return false;
+    }
+
+    char preamble[container_preamble_size];
+    std::string fields;
+    bool valid = file.read(preamble, sizeof(preamble)) && parse_container_preamble(preamble, header);
+
+    // the offset and length are only what the file says: check them against its size, as the mapped path does,
+    // before allocating anything for them. a pipe has no size to check, so it is read a block at a time and can only
+    // make us allocate as much as it actually sends.
+    std::error_code size_error;
+    const uintmax_t file_size = std::filesystem::is_regular_file(filename, size_error) ? std::filesystem::file_size(filename, size_error) : 0;
+    if (valid && !size_error && file_size > 0)
+    {
+        valid = header.payload_offset <= file_size && header.payload_length <= file_size - header.payload_offset;
+    }
+
+    valid = valid
+        && read_exactly(file, fields, header.payload_offset - container_preamble_size)
+        && parse_container_fields(std::span<const char>(fields), header)
+        && read_exactly(file, payload, header.payload_length)
+        && (!header.has_checksum || crc32(std::span<const char>(payload)) == header.checksum);
+
+    if (!valid) {
+        std::cerr << "Not a valid container file: " << filename << std::endl;
+    }
+
+    return valid;
+}
+
+/// <summary>
+/// encrypt a file straight into a binary container, the container counterpart of read_file, get_student_name,
+/// encrypt_decrypt and save_data_file. the payload is the encrypted data alone, as a converted data file holds.
+/// </summary>
+/// 
+/// <param name="input_filename">file to read, read_file's default string is used if it cannot be opened</param>
+/// <param name="container_filename">container file to write</param>
+/// <param name="key">key to use in encryption</param>
+/// <param name="with_checksum">store a CRC-32 of the payload</param>
+/// 
+/// <returns>true if the container was written</returns>
+bool encrypt_file_to_container(const std::string& input_filename, const std::string& container_filename, const std::string& key, bool with_checksum = true)
+{
+    assert(key.length() > 0);
+
+    std::string data = read_file(input_filename);
+    const std::string student_name = get_student_name(data);
+
+    // encrypt_decrypt needs at least one byte, an empty file is stored as an empty payload
+    if (!data.empty())
+    {
+        encrypt_decrypt(std::span<char>(data), key);
+    }
+
+    return save_container_file(container_filename, student_name, current_date_string(), key, std::span<const char>(data), with_checksum);
+}
+
+/// <summary>
+/// convert a text data file (name, date, key, data) written by save_data_file into a binary container,
+/// keeping the original timestamp. kept for data files written before encrypt_file_to_container.
+/// </summary>
+/// 
+/// <param name="text_filename">data file to convert</param>
+/// <param name="container_filename">container file to write</param>
+/// <param name="with_checksum">store a CRC-32 of the payload</param>
+/// 
+/// <returns>true if the container was written</returns>
+bool convert_data_file_to_container(const std::string& text_filename, const std::string& container_filename, bool with_checksum = true)
+{
+    std::ifstream file(text_filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error opening file: " << text_filename << std::endl;
+
+        return false;
+    }
+
+    // Lines 1-3: student name, timestamp, key used
+    std::string student_name;
+    std::string timestamp;
+    std::string key;
+    if (!std::getline(file, student_name) || !std::getline(file, timestamp) || !std::getline(file, key)) {
+        std::cerr << "Not a valid data file: " << text_filename << std::endl;
+
+        return false;
+    }
+
+    // Line 4+: data, without the newline save_data_file ends the file with
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string data = contents.str();
+    if (data.empty()) {
+        std::cerr << "Not a valid data file: " << text_filename << std::endl;
+
+        return false;
+    }
+    data.pop_back();
+
+    return save_container_file(container_filename, student_name, timestamp, key, std::span<const char>(data), with_checksum);
+}
+
+/// <summary>
+/// decrypt the payload of a container into a text data file. where memory mapping is available the payload
+/// is transformed straight out of the mapped container at its recorded offset.
+/// </summary>
+/// 
+/// <param name="container_filename">container file to read</param>
+/// <param name="output_filename">data file to write</param>
+/// 
+/// <returns>true if the output file was written</returns>
+bool decrypt_container_file(const std::string& container_filename, const std::string& output_filename)
+{
+    container_header header;
+
+#if defined(ENCRYPTION_HAS_MMAP)
+    mapped_file input;
+    if (input.open_read(container_filename))
+    {
+        const bool valid = input.size() >= container_preamble_size
+            && parse_container_preamble(input.data(), header)
+            && header.payload_offset <= input.size()
+            && header.payload_length <= input.size() - header.payload_offset
+            && parse_container_fields(std::span<const char>(input.data() + container_preamble_size, static_cast<size_t>(header.payload_offset) - container_preamble_size), header);
+
+        const std::span<const char> payload(input.data() + header.payload_offset, valid ? static_cast<size_t>(header.payload_length) : 0);
+
+        if (!valid || header.key.empty() || (header.has_checksum && crc32(payload) != header.checksum)) {
+            std::cerr << "Not a valid container file: " << container_filename << std::endl;
+
+            return false;
+        }
+
+        return write_data_file_mapped(output_filename, header.student_name, header.key, payload, false);
+    }
+#endif
+
+    std::string payload;
+    if (!read_container_file(container_filename, header, payload) || header.key.empty())
+    {
+        return false;
+    }
+
+    if (!payload.empty())
+    {
+        encrypt_decrypt(std::span<char>(payload), header.key);
+    }
+
+    return save_data_file(output_filename, header.student_name, header.key, payload);
+}
+
+/// <summary>
+/// a fixed capacity queue that hands work from one pipeline stage to the next.
+/// push blocks while the queue is full, so a fast stage cannot run arbitrarily far ahead of a slow one.
+/// </summary>
+template <typename T>
+class bounded_queue
+{
+public:
+    explicit bounded_queue(size_t capacity) : capacity(capacity)
+    {
+        assert(capacity > 0);
+    }
+
+    /// <summary>
+    /// add an item, waiting for room if the queue is full
+    /// </summary>
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        lock.unlock();
+
+        not_empty.notify_one();
+    }
+
+    /// <summary>
+    /// take the oldest item, waiting for one if the queue is empty
+    /// </summary>
+    /// <returns>false once the queue is closed and has been drained</returns>
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty())
+        {
+            return false;
+        }
+
+        item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+
+        not_full.notify_one();
+        return true;
+    }
+
+    /// <summary>
+    /// no more items will be pushed, wake everyone waiting to pop
+    /// </summary>
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        not_empty.notify_all();
+    }
+
+private:
+    const size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
+/// <summary>
+/// one file moving through the batch pipeline
+/// </summary>
+struct batch_job
+{
+    std::string output_filename;
+    std::string student_name;
+    std::string data;
+};
+
+/// <summary>
+/// read a whole file the way read_file sees it (every line ends in a newline) without going line by line
+/// </summary>
+/// 
+/// <param name="filename">file to read</param>
+/// <param name="file_text">receives the file contents</param>
+/// 
+/// <returns>false if the file could not be opened</returns>
+static bool read_file_text(const std::string& filename, std::string& file_text)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    file_text = contents.str();
+
+    // read_file ends every line it reads with a newline, including a last line that had none in the file
+    if (!file_text.empty() && file_text.back() != '\n')
+    {
+        file_text += '\n';
+    }
+
+    return true;
+}
+
+/// <summary>
+/// list the files a batch run should encrypt
+/// </summary>
+/// 
+/// <param name="source">a directory (every regular file in it) or a manifest file (one input path per line)</param>
+/// 
+/// <returns>input file names in a stable order</returns>
+std::vector<std::string> list_batch_inputs(const std::string& source)
+{
+    std::vector<std::string> inputs;
+
+    if (std::filesystem::is_directory(source))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(source))
+        {
+            if (entry.is_regular_file())
+            {
+                inputs.push_back(entry.path().string());
+            }
+        }
+        std::sort(inputs.begin(), inputs.end());
+    }
+    else
+    {
+        std::ifstream manifest(source);
+        if (!manifest.is_open()) {
+            std::cerr << "Error opening file: " << source << std::endl;
+
+            return inputs;
+        }
+
+        std::string line;
+        while (std::getline(manifest, line)) {
+            if (!line.empty()) {
+                inputs.push_back(line);
+            }
+        }
+    }
+
+    return inputs;
+}
+
+/// <summary>
+/// encrypt many files into data files as a three stage pipeline: reader threads load files, compute threads
+/// encrypt them, and writer threads save them, with bounded queues between the stages.
+/// each output has the same layout save_data_file writes.
+/// </summary>
+/// 
+/// <param name="inputs">files to encrypt</param>
+/// <param name="output_directory">where to write the data files, named after their inputs. inputs that share a name,
+/// or an output that would overwrite its own input, are refused before anything is written.</param>
+/// <param name="key">key to use in encryption</param>
+/// <param name="io_threads">threads for each of the read and write stages</param>
+/// <param name="compute_threads">threads for the encrypt stage</param>
+/// 
+/// <returns>number of files written, failed writes not counted</returns>
+size_t run_batch(const std::vector<std::string>& inputs, const std::string& output_directory, const std::string& key, unsigned io_threads, unsigned compute_threads)
+{
+    assert(key.length() > 0);
+    assert(io_threads > 0);
+    assert(compute_threads > 0);
+
+    // every output is named after its input, so two inputs with the same name would overwrite one another, and an
+    // output directory holding the inputs would have them overwritten
+    std::vector<std::string> output_filenames;
+    std::unordered_map<std::string, size_t> input_with_name;
+    for (size_t index = 0; index < inputs.size(); ++index)
+    {
+        const std::filesystem::path name = std::filesystem::path(inputs[index]).filename();
+        const auto named = input_with_name.emplace(name.string(), index);
+        if (!named.second)
+        {
+            std::cerr << "Batch refused: " << inputs[named.first->second] << " and " << inputs[index]
+                << " would both be written to " << name.string() << std::endl;
+            return 0;
+        }
+
+        const std::filesystem::path output = std::filesystem::path(output_directory) / name;
+        std::error_code output_error;
+        std::error_code input_error;
+        const std::filesystem::path output_path = std::filesystem::weakly_canonical(output, output_error);
+        const std::filesystem::path input_path = std::filesystem::weakly_canonical(inputs[index], input_error);
+        if (!output_error && !input_error && output_path == input_path)
+        {
+            std::cerr << "Batch refused: writing " << output.string() << " would overwrite its input" << std::endl;
+            return 0;
+        }
+        output_filenames.push_back(output.string());
+    }
+
+    std::error_code directory_error;
+    std::filesystem::create_directories(output_directory, directory_error);
+    if (directory_error)
+    {
+        std::cerr << "Batch failed: cannot create " << output_directory << ": " << directory_error.message() << std::endl;
+        return 0;
+    }
+
+    // enough slack for each stage to keep busy while the next one catches up
+    bounded_queue<batch_job> to_encrypt(4 * static_cast<size_t>(compute_threads));
+    bounded_queue<batch_job> to_write(4 * static_cast<size_t>(io_threads));
+
+    std::atomic<size_t> next_input{ 0 };
+    std::atomic<size_t> files_written{ 0 };
+    std::atomic<size_t> files_failed{ 0 };
+    std::atomic<size_t> bytes_encrypted{ 0 };
+
+    // every file uses the same key, so the encrypt stage shares one context instead of looking it up per file
+    const auto context = shared_key_contexts().get(key);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // stage 1: load each input and pull the student name off its first line
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < io_threads; ++i)
+    {
+        readers.emplace_back([&]
+        {
+            for (size_t index = next_input.fetch_add(1); index < inputs.size(); index = next_input.fetch_add(1))
+            {
+                batch_job job;
+                // encrypt_decrypt needs at least one byte, so empty files are skipped along with unreadable ones
+                if (!read_file_text(inputs[index], job.data) || job.data.empty())
+                {
+                    std::cerr << "Skipping unreadable or empty file: " << inputs[index] << std::endl;
+                    ++files_failed;
+                    continue;
+                }
+
+                job.output_filename = output_filenames[index];
+                job.student_name = get_student_name(job.data);
+                to_encrypt.push(std::move(job));
+            }
+        });
+    }
+
+    // stage 2: encrypt each file's data in place
+    std::vector<std::thread> encrypters;
+    for (unsigned i = 0; i < compute_threads; ++i)
+    {
+        encrypters.emplace_back([&]
+        {
+            batch_job job;
+            while (to_encrypt.pop(job))
+            {
+                encrypt_decrypt(std::span<const char>(job.data), std::span<char>(job.data), *context);
+                bytes_encrypted += job.data.length();
+                to_write.push(std::move(job));
+            }
+        });
+    }
+
+    // stage 3: write each data file
+    std::vector<std::thread> writers;
+    for (unsigned i = 0; i < io_threads; ++i)
+    {
+        writers.emplace_back([&]
+        {
+            batch_job job;
+            while (to_write.pop(job))
+            {
+                if (save_data_file(job.output_filename, job.student_name, key, job.data))
+                {
+                    ++files_written;
+                }
+                else
+                {
+                    ++files_failed;
+                }
+            }
+        });
+    }
+
+    // shut the pipeline down front to back, each stage finishes once the one before it has drained
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+    to_encrypt.close();
+
+    for (auto& encrypter : encrypters)
+    {
+        encrypter.join();
+    }
+    to_write.close();
+
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double megabytes = static_cast<double>(bytes_encrypted) / (1024.0 * 1024.0);
+
+    std::cout << "Batch encrypted " << files_written << " files (" << files_failed << " failed) in "
+        << std::fixed << std::setprecision(3) << elapsed.count() << " s: "
+        << std::setprecision(0) << files_written / elapsed.count() << " files/s, "
+        << std::setprecision(1) << megabytes / elapsed.count() << " MB/s" << std::endl;
+
+    return files_written;
+}
+
+/// <summary>
+/// time every available xor kernel against the reference loop across a sweep of key lengths and payload sizes
+/// </summary>
+/// 
+/// <param name="max_payload_length">largest payload to test, payloads grow by 16x from 1 KB up to this size</param>
+void run_benchmark(size_t max_payload_length)
+{
+    // each measurement repeats until at least this many bytes are processed so small payloads still time reliably
+    const size_t min_bytes_per_measurement = 64 * 1024 * 1024;
+
+    std::vector<xor_kernel_info> kernels = { { "reference", xor_kernel_reference }, { "scalar", xor_kernel_scalar } };
+#if defined(ENCRYPTION_HAS_SSE2)
+    kernels.push_back({ "sse2", xor_kernel_sse2 });
+#endif
+#if defined(ENCRYPTION_HAS_AVX2)
+    if (cpu_supports_avx2())
+    {
+        kernels.push_back({ "avx2", xor_kernel_avx2 });
+    }
+#endif
+
+    // powers of two and their odd neighbours so both aligned and unaligned key phases are covered
+    const std::vector<size_t> key_lengths = { 1, 2, 3, 4, 7, 8, 13, 16, 31, 32, 33, 63, 64 };
+
+    std::cout << "XOR kernel benchmark, encrypt_decrypt uses: " << active_xor_kernel().name << std::endl;
+    std::cout << std::setw(12) << "payload" << std::setw(6) << "key";
+    for (const auto& kernel : kernels)
+    {
+        std::cout << std::setw(12) << kernel.name;
+    }
+    std::cout << "  (MB/s)" << std::endl;
+
+    // fixed seed so every run processes the same data
+    std::mt19937 generator(405);
+    std::uniform_int_distribution<int> byte_distribution(0, 255);
+
+    for (size_t payload_length = 1024; payload_length <= max_payload_length; payload_length *= 16)
+    {
+        std::string payload(payload_length, '\0');
+        for (auto& c : payload)
+        {
+            c = static_cast<char>(byte_distribution(generator));
+        }
+
+        std::string expected(payload_length, '\0');
+        std::string output(payload_length, '\0');
+        const size_t repetitions = std::max<size_t>(1, min_bytes_per_measurement / payload_length);
+
+        for (const auto key_length : key_lengths)
+        {
+            std::string key(key_length, '\0');
+            for (auto& c : key)
+            {
+                c = static_cast<char>(byte_distribution(generator));
+            }
+            const std::string key_stream = expand_key_stream(key);
+
+            xor_kernel_reference(payload.data(), &expected[0], payload_length, key_stream.data(), key_length, 0);
+
+            std::cout << std::setw(12) << payload_length << std::setw(6) << key_length;
+            for (const auto& kernel : kernels)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                for (size_t r = 0; r < repetitions; ++r)
+                {
+                    kernel.kernel(payload.data(), &output[0], payload_length, key_stream.data(), key_length, 0);
+                }
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+                // every kernel must produce exactly what the reference loop does
+                if (output != expected)
+                {
+                    std::cerr << "Kernel " << kernel.name << " output does not match reference!" << std::endl;
+                    return;
+                }
+
+                const double megabytes = static_cast<double>(payload_length) * repetitions / (1024.0 * 1024.0);
+                std::cout << std::setw(12) << std::fixed << std::setprecision(0) << megabytes / elapsed.count();
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // small payloads with a repeated key, where building the key stream on every call is a large share of the work
+    std::cout << std::endl << "Repeated 1 KB payloads with one key (calls/s)" << std::endl;
+    std::cout << std::setw(6) << "key" << std::setw(16) << "expand per call" << std::setw(16) << "cached context" << std::endl;
+
+    const std::string payload(1024, 'x');
+    std::string output(payload.length(), '\0');
+    const size_t calls = 200000;
+
+    for (const auto key_length : key_lengths)
+    {
+        const std::string key(key_length, 'k');
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t call = 0; call < calls; ++call)
+        {
+            const std::string key_stream = expand_key_stream(key);
+            active_xor_kernel().kernel(payload.data(), &output[0], payload.length(), key_stream.data(), key_length, 0);
+        }
+        const std::chrono::duration<double> expand_elapsed = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t call = 0; call < calls; ++call)
+        {
+            encrypt_decrypt(std::span<const char>(payload), std::span<char>(output), key);
+        }
+        const std::chrono::duration<double> cached_elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << std::setw(6) << key_length << std::setw(16) << std::setprecision(0) << calls / expand_elapsed.count()
+            << std::setw(16) << calls / cached_elapsed.count() << std::endl;
+    }
+}
+
+/// <summary>
+/// read a whole file back for comparing benchmark outputs
+/// </summary>
+static std::string read_binary_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+/// <summary>
+/// time encrypting a generated text file with the read_file / save_data_file round trip, the streaming path, and the memory mapped path
+/// </summary>
+/// 
+/// <param name="payload_length">size of the generated input file</param>
+void run_file_benchmark(size_t payload_length)
+{
+    const std::string input_filename = "benchmark_input.txt";
+    const std::string key = "password";
+
+    // lorem-ipsum-like text with a line break every so often, from a fixed seed so every run is the same
+    {
+        std::mt19937 generator(405);
+        std::uniform_int_distribution<int> letter_distribution(0, 26);
+        std::string text(payload_length, ' ');
+        for (size_t i = 0; i < payload_length; ++i)
+        {
+            const int letter = letter_distribution(generator);
+            text[i] = (i % 80 == 79) ? '\n' : (letter == 26 ? ' ' : static_cast<char>('a' + letter));
+        }
+
+        std::ofstream input(input_filename, std::ios::binary);
+        input.write(text.data(), text.size());
+    }
+
+    struct file_path
+    {
+        const char* name;
+        std::string output_filename;
+        bool (*encrypt_file)(const std::string& input_filename, const std::string& output_filename, const std::string& key);
+    };
+
+    const file_path paths[] = {
+        { "read_file/save_data_file", "benchmark_whole.txt", [](const std::string& input_filename, const std::string& output_filename, const std::string& key)
+            {
+                const std::string source_string = read_file(input_filename);
+                save_data_file(output_filename, get_student_name(source_string), key, encrypt_decrypt(source_string, key));
+                return true;
+            } },
+        { "streaming", "benchmark_streaming.txt", [](const std::string& input_filename, const std::string& output_filename, const std::string& key)
+            {
+                return encrypt_file_streaming(input_filename, output_filename, key);
+            } },
+        { "memory mapped", "benchmark_mapped.txt", encrypt_file_mapped },
+    };
+
+    std::cout << "File encryption benchmark, " << payload_length << " byte input" << std::endl;
+
+    std::string expected;
+    for (const auto& path : paths)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const bool written = path.encrypt_file(input_filename, path.output_filename, key);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // every path must write exactly what the read_file / save_data_file round trip does
+        const std::string output = read_binary_file(path.output_filename);
+        if (expected.empty())
+        {
+            expected = output;
+        }
+        const bool matches = written && output == expected;
+
+        const double megabytes = static_cast<double>(payload_length) / (1024.0 * 1024.0);
+        std::cout << std::setw(28) << path.name << std::setw(10) << std::fixed << std::setprecision(3) << elapsed.count() << " s"
+            << std::setw(10) << std::setprecision(0) << megabytes / elapsed.count() << " MB/s" << (matches ? "" : "  OUTPUT DIFFERS!") << std::endl;
+
+        std::remove(path.output_filename.c_str());
+    }
+
+    std::remove(input_filename.c_str());
+}
+
+/// <summary>
+/// time the parallel transform of one large buffer with 1 up to thread_count threads
+/// </summary>
+/// 
+/// <param name="payload_length">size of the buffer to transform</param>
+/// <param name="max_threads">largest pool to test</param>
+void run_thread_benchmark(size_t payload_length, unsigned max_threads)
+{
+    const std::string key = "password";
+    const int repetitions = 5;
+
+    // fixed seed so every run processes the same data
+    std::mt19937 generator(405);
+    std::uniform_int_distribution<int> byte_distribution(0, 255);
+    std::string payload(payload_length, '\0');
+    for (auto& c : payload)
+    {
+        c = static_cast<char>(byte_distribution(generator));
+    }
+
+    const std::string expected = encrypt_decrypt(payload, key);
+    std::string output(payload_length, '\0');
+
+    std::cout << "Parallel XOR benchmark, " << payload_length << " byte payload, " << active_xor_kernel().name << " kernel" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "MB/s" << std::setw(10) << "speedup" << std::endl;
+
+    double single_thread_rate = 0.0;
+    for (unsigned thread_count = 1; thread_count <= max_threads; ++thread_count)
+    {
+        thread_pool pool(thread_count);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; ++r)
+        {
+            encrypt_decrypt(std::span<const char>(payload), std::span<char>(output), key, pool);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (output != expected)
+        {
+            std::cerr << "Parallel output with " << thread_count << " threads does not match!" << std::endl;
+            return;
+        }
+
+        const double rate = static_cast<double>(payload_length) * repetitions / (1024.0 * 1024.0) / elapsed.count();
+        if (thread_count == 1)
+        {
+            single_thread_rate = rate;
+        }
+
+        std::cout << std::setw(8) << thread_count << std::setw(12) << std::fixed << std::setprecision(0) << rate
+            << std::setw(9) << std::setprecision(2) << rate / single_thread_rate << "x" << std::endl;
+    }
+}
+
+/// <summary>
+/// whether text is a whole number, nothing before or after it, that fits in T: a count given on the command line
+/// </summary>
+template <typename T>
+static bool parse_count(std::string_view text, T& count)
+{
+    const auto parsed = std::from_chars(text.data(), text.data() + text.length(), count);
+    return parsed.ec == std::errc() && parsed.ptr == text.data() + text.length();
+}
+
+int main(int argc, char* argv[])
+{
+    // optional container conversion: Encryption --convert <text data file> <container file>
+    if (argc > 3 && std::string(argv[1]) == "--convert")
+    {
+        return convert_data_file_to_container(argv[2], argv[3]) ? 0 : -1;
+    }
+
+    // optional container decryption: Encryption --decrypt-container <container file> <text data file>
+    if (argc > 3 && std::string(argv[1]) == "--decrypt-container")
+    {
+        return decrypt_container_file(argv[2], argv[3]) ? 0 : -1;
+    }
+
+    // optional batch mode: Encryption --batch <directory or manifest> <output directory> [io threads] [compute threads]
+    if (argc > 3 && std::string(argv[1]) == "--batch")
+    {
+        unsigned io_threads = 2;
+        unsigned compute_threads = std::max(1u, std::thread::hardware_concurrency());
+        if ((argc > 4 && (!parse_count(argv[4], io_threads) || io_threads == 0))
+            || (argc > 5 && (!parse_count(argv[5], compute_threads) || compute_threads == 0)))
+        {
+            std::cerr << "Usage: --batch <directory or manifest> <output directory> [io threads] [compute threads], thread counts of at least 1" << std::endl;
+            return -1;
+        }
+
+        const std::vector<std::string> inputs = list_batch_inputs(argv[2]);
+        const size_t files_written = run_batch(inputs, argv[3], "password", io_threads, compute_threads);
+        return files_written == inputs.size() ? 0 : -1;
+    }
+
+    // optional thread scaling benchmark: Encryption --benchmark-threads [payload bytes] [max threads]
+    if (argc > 1 && std::string(argv[1]) == "--benchmark-threads")
+    {
+        size_t payload_length = 1024ull * 1024 * 1024;
+        unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+        if ((argc > 2 && (!parse_count(argv[2], payload_length) || payload_length == 0))
+            || (argc > 3 && (!parse_count(argv[3], max_threads) || max_threads == 0)))
+        {
+            std::cerr << "Usage: --benchmark-threads [payload bytes] [max threads], both whole numbers of at least 1" << std::endl;
+            return -1;
+        }
+        run_thread_benchmark(payload_length, max_threads);
+        return 0;
+    }
+
+    // optional file benchmark mode: Encryption --benchmark-files [input bytes]
+    if (argc > 1 && std::string(argv[1]) == "--benchmark-files")
+    {
+        size_t payload_length = 256ull * 1024 * 1024;
+        if (argc > 2 && (!parse_count(argv[2], payload_length) || payload_length == 0))
+        {
+            std::cerr << "Usage: --benchmark-files [input bytes], where the input size is a whole number of at least 1" << std::endl;
+            return -1;
+        }
+        run_file_benchmark(payload_length);
+        return 0;
+    }
+
+    // optional benchmark mode: Encryption --benchmark [max payload bytes]
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        size_t max_payload_length = 1024ull * 1024 * 1024;
+        if (argc > 2 && (!parse_count(argv[2], max_payload_length) || max_payload_length == 0))
+        {
+            std::cerr << "Usage: --benchmark [max payload bytes], where the payload is a whole number of at least 1" << std::endl;
+            return -1;
+        }
+        run_benchmark(max_payload_length);
+        return 0;
+    }
+
+    std::cout << "Encyption Decryption Test!" << std::endl;
+
+    // Input file format:
     // Line 1: <student's name>
     // Line 2: <Lorem Ipsum Generator website used>
     // Lines 3+: <lorem ipsum generated with 3 paragraphs> 
@@ -129,27 +2374,68 @@ int main()
     const std::string file_name = "inputdatafile.txt";
     const std::string encrypted_file_name = "encrypteddatafile.txt";
     const std::string decrypted_file_name = "decrypteddatafile.txt";
-    const std::string source_string = read_file(file_name);
     const std::string key = "password";
 
+    // optional streaming mode: Encryption --stream
+    // same output files, but memory use stays at one chunk no matter how large the input is
+    if (argc > 1 && std::string(argv[1]) == "--stream")
+    {
+        if (encrypt_file_streaming(file_name, encrypted_file_name, key))
+        {
+            decrypt_file_streaming(encrypted_file_name, decrypted_file_name);
+        }
+
+        std::cout << "Read File: " << file_name << " - Encrypted To: " << encrypted_file_name << " - Decrypted To: " << decrypted_file_name << std::endl;
+        return 0;
+    }
+
+    // optional container mode: Encryption --container
+    // the encrypted file is a binary container instead of a text data file, decrypted back to the usual text data file
+    if (argc > 1 && std::string(argv[1]) == "--container")
+    {
+        const std::string container_file_name = "encrypteddatafile.cs405";
+        const bool round_trip = encrypt_file_to_container(file_name, container_file_name, key)
+            && decrypt_container_file(container_file_name, decrypted_file_name);
+
+        std::cout << "Read File: " << file_name << " - Encrypted To: " << container_file_name << " - Decrypted To: " << decrypted_file_name << std::endl;
+        return round_trip ? 0 : -1;
+    }
+
+    // optional memory mapped mode: Encryption --mmap
+    // same output files, written straight from one mapping into another
+    if (argc > 1 && std::string(argv[1]) == "--mmap")
+    {
+        if (encrypt_file_mapped(file_name, encrypted_file_name, key))
+        {
+            decrypt_file_mapped(encrypted_file_name, decrypted_file_name);
+        }
+
+        std::cout << "Read File: " << file_name << " - Encrypted To: " << encrypted_file_name << " - Decrypted To: " << decrypted_file_name << std::endl;
+        return 0;
+    }
+
+    // one buffer holds the data for the whole run, it is encrypted and then decrypted in place
+    std::string data = read_file(file_name);
+
     // get the student name from the data file
-    const std::string student_name = get_student_name(source_string);
+    const std::string student_name = get_student_name(data);
 
-    // encrypt sourceString with key
-    const std::string encrypted_string = encrypt_decrypt(source_string, key);
+    // encrypt the data in place with key
+    encrypt_decrypt(std::span<char>(data), key);
 
-    // save encrypted_string to file
-    save_data_file(encrypted_file_name, student_name, key, encrypted_string);
+    // save the encrypted data to file
+    save_data_file(encrypted_file_name, student_name, key, data);
 
-    // decrypt encryptedString with key
-    const std::string decrypted_string = encrypt_decrypt(encrypted_string, key);
+    // decrypt the data in place with key
+    encrypt_decrypt(std::span<char>(data), key);
 
-    // save decrypted_string to file
-    save_data_file(decrypted_file_name, student_name, key, decrypted_string);
+    // save the decrypted data to file
+    save_data_file(decrypted_file_name, student_name, key, data);
 
     std::cout << "Read File: " << file_name << " - Encrypted To: " << encrypted_file_name << " - Decrypted To: " << decrypted_file_name << std::endl;
 
     // students submit input file, encrypted file, decrypted file, source code file, and key used
+    return 0;
 }
 
 // Run program: Ctrl + F5 or Debug > Start Without Debugging menu
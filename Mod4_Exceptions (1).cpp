@@ -137,6 +137,8 @@ int main()
     catch (...) {
         std::cout << "An errant exception was caught by the catch-all. Time to do some digging." << std::endl;
     }
+
+    return 0;
 }
 
 // Run program: Ctrl + F5 or Debug > Start Without Debugging menu
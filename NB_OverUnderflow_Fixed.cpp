@@ -1,215 +1,2464 @@
 // NumericOverflows.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
 
+#include <algorithm>    // std::min, std::max, std::fill_n
+#include <array>        // std::array
+#include <atomic>       // std::atomic
+#include <bit>          // std::popcount
+#include <charconv>     // std::from_chars
+#include <cassert>      // assert
+#include <chrono>       // std::chrono::steady_clock
+#include <cmath>        // std::floor, std::fabs, std::isinf, std::ldexp, std::nextafter
+#include <compare>      // operator<=>
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint64_t
+#include <cstring>      // std::memcpy
+#include <functional>   // std::function
+#include <iomanip>      // std::setprecision
 #include <iostream>     // std::cout
 #include <limits>       // std::numeric_limits
+#include <memory>       // std::shared_ptr
+#include <mutex>        // std::mutex
+#include <random>       // std::mt19937_64
+#include <span>         // std::span
+#include <sstream>      // std::ostringstream
+#include <stdexcept>    // std::overflow_error, std::underflow_error, std::domain_error
+#include <string>       // std::string
+#include <string_view>  // std::string_view
+#include <thread>       // std::thread
+#include <type_traits>  // std::is_same, std::make_unsigned
+#include <typeinfo>     // std::type_info
+#include <vector>       // std::vector
+
+// The batch API uses AVX2 when the CPU has it. It is not part of the x64 baseline, so it is compiled in on any
+// x86 target and only selected at runtime once the CPU reports support for it.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define OVERFLOW_HAS_AVX2 1
+#endif
+
+// MSVC allows AVX2 intrinsics in any function, GCC and Clang need the function marked for that target
+#if defined(_MSC_VER)
+#define OVERFLOW_TARGET_AVX2
+#else
+#define OVERFLOW_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// error reporting kept out of line, so the code for it does not crowd the no-overflow path it branches off
+#if defined(_MSC_VER)
+#define OVERFLOW_COLD __declspec(noinline)
+#else
+#define OVERFLOW_COLD __attribute__((noinline, cold))
+#endif
+
+// The overflow checks ask std::numeric_limits whether a type is an integer and whether it is signed, rather than the
+// <type_traits> helpers, which only know about 128 bit integers when compiler extensions are turned on.
+template <typename T>
+constexpr bool is_integer_type = std::numeric_limits<T>::is_integer;
+
+template <typename T>
+constexpr bool is_signed_type = std::numeric_limits<T>::is_signed;
+
+/// <summary>
+/// The unsigned type the same width as T, for std::make_unsigned's standard types and the 128 bit integers it may not know
+/// </summary>
+template <typename T>
+struct unsigned_of
+{
+    using type = typename std::make_unsigned<T>::type;
+};
+
+#if defined(__SIZEOF_INT128__)
+template <>
+struct unsigned_of<__int128>
+{
+    using type = unsigned __int128;
+};
+
+template <>
+struct unsigned_of<unsigned __int128>
+{
+    using type = unsigned __int128;
+};
+#endif
+
+/// <summary>
+/// Whether a value is below zero, without tripping "comparison is always false" warnings for unsigned types
+/// </summary>
+template <typename T>
+constexpr bool is_negative(T const& value)
+{
+    if constexpr (is_signed_type<T>) {
+        return value < 0;
+    }
+    else {
+        return false;
+    }
+}
+
+/// <summary>
+/// Fast path for integers: result = start + (increment * steps) using the compiler's overflow-checked builtins.
+/// Compilers without the builtins always report failure and the caller falls back to the division based check.
+/// </summary>
+/// <returns>true if the whole expression fit in T</returns>
+template <typename T>
+constexpr bool checked_multiply_add(T const& start, T const& increment, unsigned long int const& steps, T& result)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    T product{};
+    return !__builtin_mul_overflow(increment, steps, &product) && !__builtin_add_overflow(start, product, &result);
+#else
+    (void)start; (void)increment; (void)steps; (void)result;
+    return false;
+#endif
+}
+
+/// <summary>
+/// How many whole steps of magnitude fit in room, but no more than steps (all of them when magnitude is zero).
+/// Worked out in U, as for 128 bit types the quotient may not fit in an unsigned long long.
+/// </summary>
+template <typename U>
+constexpr unsigned long long steps_that_fit(U const& room, U const& magnitude, unsigned long int const& steps)
+{
+    if (magnitude == 0) {
+        return steps;
+    }
+
+    const U fitting = static_cast<U>(room / magnitude);
+    return fitting < steps ? static_cast<unsigned long long>(fitting) : steps;
+}
+
+// Real numbers pick up rounding error on every step of the loop, and for short runs that error decides whether
+// the loop saw an overflow at all. Up to this many steps the loop is replayed exactly, past it the analytic check is used.
+constexpr unsigned long int real_number_replay_steps = 64;
+
+/// <summary>
+/// What a checked calculation ran into
+/// </summary>
+enum class overflow_status
+{
+    none,
+    overflow,
+    underflow,
+    // no answer at all, e.g. dividing by zero
+    invalid
+};
+
+/// <summary>
+/// Which arithmetic a checked calculation was doing when it ran out of range
+/// </summary>
+enum class checked_operation
+{
+    add,
+    subtract,
+    multiply,
+    divide,
+    shift_left,
+    shift_right
+};
+
+/// <summary>
+/// The outcome of a checked calculation, without any printing so it can be worked out in a constant expression
+/// </summary>
+template <typename T>
+struct checked_result
+{
+    // the answer, or the saturated value (max / lowest) if the calculation did not fit
+    T value;
+    overflow_status status;
+    // the value reached just before the step that did not fit (same as value when status is none)
+    T reached;
+    // which step, counting from 0, did not fit (0 when status is none)
+    unsigned long long step;
+};
+
+/// <summary>
+/// std::floor is not constexpr until C++23, this is enough for the long doubles used by the real number checks
+/// </summary>
+constexpr long double floor_constexpr(long double value)
+{
+    // Logic is: from 2^63 up every long double is already a whole number (and would not fit in the cast below),
+    // the comparison also lets NaN and infinity through untouched
+    constexpr long double whole_numbers_from = 9223372036854775808.0L;
+    if (!(value > -whole_numbers_from && value < whole_numbers_from)) {
+        return value;
+    }
+
+    const long double truncated = static_cast<long double>(static_cast<long long>(value));
+    return truncated > value ? truncated - 1 : truncated;
+}
+
+/// <summary>
+/// numerator / denominator, held to between -cap and cap without letting the division itself leave the range of long double
+/// </summary>
+constexpr long double capped_quotient(long double numerator, long double denominator, long double cap)
+{
+    if (denominator < 0) {
+        numerator = -numerator;
+        denominator = -denominator;
+    }
+
+    // Logic is: a denominator below one is multiplied up to compare with, as dividing a denormal numerator down would
+    // round away the very bits being compared; a larger one cannot overflow the division
+    const long double magnitude = numerator < 0 ? -numerator : numerator;
+    if (denominator < 1 ? magnitude >= denominator * cap : magnitude / cap >= denominator) {
+        return numerator < 0 ? -cap : cap;
+    }
+    return numerator / denominator;
+}
+
+/// <summary>
+/// What the real number checks divide their values by before working with them. Quarters (exact, as it is a power of two)
+/// keep every sum inside the range of long double even when T is long double, but would lose the lowest bits of a long
+/// double denormal, so a start and step size that are both below one (and cannot reach the limits) are left whole.
+/// </summary>
+template <typename T>
+constexpr long double real_number_scale(T const& start, T const& step_size)
+{
+    return (start < 1 && start > -1 && step_size < 1 && step_size > -1) ? 1.0L : 4.0L;
+}
+
+/// <summary>
+/// Turn a value worked out divided by scale back into T, kept inside the range of T in case rounding nudged it past a limit
+/// </summary>
+template <typename T>
+constexpr T from_scaled(long double scaled, long double scale)
+{
+    // NaN would fail every comparison below and come out as the lowest value
+    if (scaled != scaled) {
+        return static_cast<T>(scaled);
+    }
+
+    const long double highest = static_cast<long double>(std::numeric_limits<T>::max()) / scale;
+    const long double lowest = static_cast<long double>(std::numeric_limits<T>::lowest()) / scale;
+    return static_cast<T>(std::max(lowest, std::min(scaled, highest)) * scale);
+}
+
+/// <summary>
+/// start + (increment * steps) for unsigned integers, which can only ever overflow
+/// </summary>
+template <typename T>
+constexpr checked_result<T> checked_add_unsigned(T const& start, T const& increment, unsigned long int const& steps)
+{
+    T result{};
+    if (checked_multiply_add(start, increment, steps, result)) {
+        return { result, overflow_status::none, result, 0 };
+    }
+
+    // Work out how many whole increments fit between start and max. A step count that fits means the final value is
+    // in range, so the multiply below cannot wrap; a count that does not fit gives the value the loop stopped at.
+    const T room = static_cast<T>(std::numeric_limits<T>::max() - start);
+    const unsigned long long completed_steps = steps_that_fit(room, increment, steps);
+    result = static_cast<T>(start + static_cast<T>(static_cast<T>(completed_steps) * increment));
+
+    if (completed_steps == steps) {
+        return { result, overflow_status::none, result, 0 };
+    }
+    return { std::numeric_limits<T>::max(), overflow_status::overflow, result, completed_steps };
+}
+
+/// <summary>
+/// start + (increment * steps) for signed integers, a negative increment heads for the lowest value instead
+/// </summary>
+template <typename T>
+constexpr checked_result<T> checked_add_signed(T const& start, T const& increment, unsigned long int const& steps)
+{
+    T result{};
+    if (checked_multiply_add(start, increment, steps, result)) {
+        return { result, overflow_status::none, result, 0 };
+    }
+
+    // Either an overflow, or a product that overflowed on its own but lands back in range once start is added.
+    // Work out how many whole increments fit between start and the limit being approached, in unsigned arithmetic
+    // (which wraps instead of overflowing, and the true distance always fits in the unsigned type).
+    using U = typename unsigned_of<T>::type;
+    const bool going_down = increment < 0;
+    const U room = going_down
+        ? static_cast<U>(static_cast<U>(start) - static_cast<U>(std::numeric_limits<T>::lowest()))
+        : static_cast<U>(static_cast<U>(std::numeric_limits<T>::max()) - static_cast<U>(start));
+    const U magnitude = going_down ? static_cast<U>(U(0) - static_cast<U>(increment)) : static_cast<U>(increment);
+
+    // Logic is: a step count that fits means the final value is in range, and wrapping unsigned math gives it exactly
+    const unsigned long long completed_steps = steps_that_fit(room, magnitude, steps);
+    const U distance = static_cast<U>(static_cast<U>(completed_steps) * magnitude);
+    result = static_cast<T>(going_down ? static_cast<U>(static_cast<U>(start) - distance) : static_cast<U>(static_cast<U>(start) + distance));
+
+    if (completed_steps == steps) {
+        return { result, overflow_status::none, result, 0 };
+    }
+    if (going_down) {
+        return { std::numeric_limits<T>::lowest(), overflow_status::underflow, result, completed_steps };
+    }
+    return { std::numeric_limits<T>::max(), overflow_status::overflow, result, completed_steps };  // Same saturated value the loop returned
+}
+
+/// <summary>
+/// start + (increment * steps) for real numbers
+/// </summary>
+template <typename T>
+constexpr checked_result<T> checked_add_real(T const& start, T const& increment, unsigned long int const& steps)
+{
+    if (steps <= real_number_replay_steps) {
+        // The original step by step loop
+        T result = start;
+
+        for (unsigned long int i = 0; i < steps; ++i)
+        {
+            // Check for overflow before adding next increment
+            // Logic is: if the result is greater than the max value minus the increment, then one more increment will overflow
+            if (result > std::numeric_limits<T>::max() - increment) {
+                return { std::numeric_limits<T>::max(), overflow_status::overflow, result, i };  // Break the loop
+            }
+            // A negative increment heads for the lowest value instead, as it does in the worked out version below
+            else if (increment < 0 && result < std::numeric_limits<T>::lowest() - increment) {
+                return { std::numeric_limits<T>::lowest(), overflow_status::underflow, result, i };
+            }
+            // If no overflow is detected, addition can continue safely
+            else {
+                result += increment;
+            }
+        }
+
+        // Return the result after incrementing is complete, i.e. no overflow occurred
+        return { result, overflow_status::none, result, 0 };
+    }
+
+    // Real numbers: the loop overflowed on the last step if the value before it was above max - increment,
+    // so only that one comparison is needed. Long double keeps the products exact for float and double, and working
+    // in quarters (see real_number_scale) keeps every sum below inside its range even when T is long double.
+    const long double scale = real_number_scale(start, increment);
+    const long double wide_start = static_cast<long double>(start) / scale;
+    const long double wide_increment = static_cast<long double>(increment) / scale;
+    const long double threshold = (increment > 0
+        ? static_cast<long double>(static_cast<T>(std::numeric_limits<T>::max() - increment))
+        : static_cast<long double>(static_cast<T>(std::numeric_limits<T>::lowest() - increment))) / scale;
+    const long double last_step = static_cast<long double>(steps - 1);
+
+    bool overflow = increment > 0;
+    bool underflow = increment < 0;
+    long double before_last = 0.0L;
+
+    // Logic is: once increment * (steps - 1) is past half the range (of the scaled values), no start can bring the
+    // value before the last step back under the threshold, so it is out of range without working it out
+    const long double magnitude = wide_increment < 0 ? -wide_increment : wide_increment;
+    if (!(magnitude > (std::numeric_limits<long double>::max() / 2) / last_step)) {
+        before_last = wide_start + wide_increment * last_step;
+        overflow = overflow && before_last > threshold;
+        underflow = underflow && before_last < threshold;
+    }
+
+    if (!overflow && !underflow) {
+        const T result = from_scaled<T>(before_last + wide_increment, scale);
+        return { result, overflow_status::none, result, 0 };
+    }
+
+    // The loop stopped at the first step whose value was past the threshold, capped below steps since we know the last one was
+    const long double stopped_at = floor_constexpr(capped_quotient(threshold - wide_start, wide_increment, last_step)) + 1;
+    const long double completed = std::max(0.0L, std::min(stopped_at, last_step));
+    // (no steps completed is just start, which also keeps an infinite increment from making 0 * infinity of it)
+    const T result = completed == 0 ? start : from_scaled<T>(wide_start + wide_increment * completed, scale);
+
+    if (underflow) {
+        return { std::numeric_limits<T>::lowest(), overflow_status::underflow, result, static_cast<unsigned long long>(completed) };
+    }
+    return { std::numeric_limits<T>::max(), overflow_status::overflow, result, static_cast<unsigned long long>(completed) };  // Same saturated value the loop returned
+}
+
+/// <summary>
+/// start + (increment * steps) without printing anything, usable in constant expressions.
+/// The signed, unsigned and real number versions are picked at compile time, so each type only carries its own checks.
+/// </summary>
+/// <typeparam name="T">A type that with basic math functions</typeparam>
+/// <param name="start">The number to start with</param>
+/// <param name="increment">How much to add each step</param>
+/// <param name="steps">The number of steps to iterate</param>
+/// <returns>start + (increment * steps), or max / lowest with the value reached before it went out of range</returns>
+template <typename T>
+constexpr checked_result<T> checked_add_numbers(T const& start, T const& increment, unsigned long int const& steps)
+{
+    if constexpr (!is_integer_type<T>) {
+        return checked_add_real(start, increment, steps);
+    }
+    else if constexpr (is_signed_type<T>) {
+        return checked_add_signed(start, increment, steps);
+    }
+    else {
+        return checked_add_unsigned(start, increment, steps);
+    }
+}
+
+/// <summary>
+/// start - (decrement * steps) for unsigned integers, which can only ever underflow
+/// </summary>
+template <typename T>
+constexpr checked_result<T> checked_subtract_unsigned(T const& start, T const& decrement, unsigned long int const& steps)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    // Fast path: the whole decrement fits in T and does not take start below zero
+    T product{};
+    if (!__builtin_mul_overflow(decrement, steps, &product) && product <= start) {
+        const T result = static_cast<T>(start - product);
+        return { result, overflow_status::none, result, 0 };
+    }
+#endif
+
+    // Logic is: the loop stopped once result < decrement, so the number of whole decrements it took is start / decrement
+    const unsigned long long completed_steps = steps_that_fit(start, decrement, steps);
+    const T result = static_cast<T>(start - static_cast<T>(static_cast<T>(completed_steps) * decrement));
+
+    if (completed_steps == steps) {
+        return { result, overflow_status::none, result, 0 };
+    }
+    return { std::numeric_limits<T>::lowest(), overflow_status::underflow, result, completed_steps };  // Same saturated value the loop returned
+}
+
+/// <summary>
+/// start - (decrement * steps) for signed integers. As with the original loop, going below zero counts as an underflow;
+/// a negative decrement moves the value up instead and overflows past max.
+/// </summary>
+template <typename T>
+constexpr checked_result<T> checked_subtract_signed(T const& start, T const& decrement, unsigned long int const& steps)
+{
+    using U = typename unsigned_of<T>::type;
+
+    if (decrement < 0) {
+        // Subtracting a negative number: count how many steps fit below max
+        const U room = static_cast<U>(static_cast<U>(std::numeric_limits<T>::max()) - static_cast<U>(start));
+        const U magnitude = static_cast<U>(U(0) - static_cast<U>(decrement));
+        const unsigned long long completed_steps = steps_that_fit(room, magnitude, steps);
+        const T result = static_cast<T>(static_cast<U>(static_cast<U>(start) + static_cast<U>(static_cast<U>(completed_steps) * magnitude)));
+
+        if (completed_steps == steps) {
+            return { result, overflow_status::none, result, 0 };
+        }
+        return { std::numeric_limits<T>::max(), overflow_status::overflow, result, completed_steps };
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    // Fast path: the whole decrement fits in T and does not take start below zero
+    T product{};
+    if (start >= 0 && !__builtin_mul_overflow(decrement, steps, &product) && product <= start) {
+        const T result = static_cast<T>(start - product);
+        return { result, overflow_status::none, result, 0 };
+    }
+#endif
+
+    // Logic is: the loop stopped once result < decrement, so the number of whole decrements it took is start / decrement
+    // (none at all if start was already negative)
+    const unsigned long long completed_steps = start >= 0 ? steps_that_fit(static_cast<U>(start), static_cast<U>(decrement), steps) : 0;
+    const T result = static_cast<T>(static_cast<U>(static_cast<U>(start) - static_cast<U>(static_cast<U>(completed_steps) * static_cast<U>(decrement))));
+
+    if (completed_steps == steps) {
+        return { result, overflow_status::none, result, 0 };
+    }
+    return { std::numeric_limits<T>::lowest(), overflow_status::underflow, result, completed_steps };  // Same saturated value the loop returned
+}
+
+/// <summary>
+/// start - (decrement * steps) for real numbers, with the same below zero rule as the integers
+/// </summary>
+template <typename T>
+constexpr checked_result<T> checked_subtract_real(T const& start, T const& decrement, unsigned long int const& steps)
+{
+    if (steps <= real_number_replay_steps) {
+        // The original step by step loop
+        T result = start;
+
+        for (unsigned long int i = 0; i < steps; ++i)
+        {
+            // A negative decrement heads for max instead, as it does with the integers and in the worked out version below
+            if (decrement < 0) {
+                if (result > std::numeric_limits<T>::max() + decrement) {
+                    return { std::numeric_limits<T>::max(), overflow_status::overflow, result, i };
+                }
+            }
+            // Check for underflow before subtracting next decrement
+            // Logic is: if the result is less than the lowest value plus the decrement, then one more decrement will underflow,
+            // and as with the integers going below zero counts too
+            else if (result < std::numeric_limits<T>::lowest() + decrement || result < decrement) {
+                return { std::numeric_limits<T>::lowest(), overflow_status::underflow, result, i };  // Break the loop
+            }
+
+            // If no underflow is detected, subtraction can continue safely
+            result -= decrement;
+        }
+
+        // Return the result after decrementing is complete, i.e. no underflow occurred
+        return { result, overflow_status::none, result, 0 };
+    }
+
+    // Scaled for the same reason as checked_add_real
+    const long double scale = real_number_scale(start, decrement);
+    const long double wide_start = static_cast<long double>(start) / scale;
+    const long double wide_decrement = static_cast<long double>(decrement) / scale;
+    const long double last_step = static_cast<long double>(steps - 1);
+
+    // Only the value before the last step matters: the loop underflowed if it was below the decrement,
+    // or (for a negative decrement) overflowed if it was above max + decrement
+    const long double threshold = decrement < 0
+        ? static_cast<long double>(static_cast<T>(std::numeric_limits<T>::max() + decrement)) / scale
+        : wide_decrement;
+
+    bool overflow = decrement < 0;
+    bool underflow = !(decrement < 0);
+    long double before_last = 0.0L;
+
+    // As with adding, a decrement this large takes the value out of range whatever the start
+    const long double magnitude = wide_decrement < 0 ? -wide_decrement : wide_decrement;
+    if (!(magnitude > (std::numeric_limits<long double>::max() / 2) / last_step)) {
+        before_last = wide_start - wide_decrement * last_step;
+        overflow = overflow && before_last > threshold;
+        underflow = underflow && before_last < threshold;
+    }
+
+    if (!overflow && !underflow) {
+        const T result = from_scaled<T>(before_last - wide_decrement, scale);
+        return { result, overflow_status::none, result, 0 };
+    }
+
+    // The loop stopped at the first step whose value was past the threshold, capped below steps since we know the last one was
+    long double stopped_at = 0.0L;
+    if (overflow) {
+        stopped_at = floor_constexpr(capped_quotient(threshold - wide_start, -wide_decrement, last_step)) + 1;
+    }
+    else if (wide_start >= 0 && decrement != 0) {
+        stopped_at = floor_constexpr(capped_quotient(wide_start, wide_decrement, last_step));
+    }
+    const long double completed = std::max(0.0L, std::min(stopped_at, last_step));
+    const T result = completed == 0 ? start : from_scaled<T>(wide_start - wide_decrement * completed, scale);
+
+    if (overflow) {
+        return { std::numeric_limits<T>::max(), overflow_status::overflow, result, static_cast<unsigned long long>(completed) };
+    }
+    return { std::numeric_limits<T>::lowest(), overflow_status::underflow, result, static_cast<unsigned long long>(completed) };  // Same saturated value the loop returned
+}
+
+/// <summary>
+/// start - (decrement * steps) without printing anything, usable in constant expressions.
+/// The signed, unsigned and real number versions are picked at compile time, so each type only carries its own checks.
+/// </summary>
+/// <typeparam name="T">A type that with basic math functions</typeparam>
+/// <param name="start">The number to start with</param>
+/// <param name="decrement">How much to subtract each step</param>
+/// <param name="steps">The number of steps to iterate</param>
+/// <returns>start - (decrement * steps), or lowest / max with the value reached before it went out of range</returns>
+template <typename T>
+constexpr checked_result<T> checked_subtract_numbers(T const& start, T const& decrement, unsigned long int const& steps)
+{
+    if constexpr (!is_integer_type<T>) {
+        return checked_subtract_real(start, decrement, steps);
+    }
+    else if constexpr (is_signed_type<T>) {
+        return checked_subtract_signed(start, decrement, steps);
+    }
+    else {
+        return checked_subtract_unsigned(start, decrement, steps);
+    }
+}
+
+/// <summary>
+/// A record of add_numbers / subtract_numbers running out of range, kept until it is drained so the console message
+/// can be written off the hot path. The operands are kept as the raw bytes of T, operand<T>() gives them back.
+/// </summary>
+struct overflow_event
+{
+    // which operand is which in operands
+    static constexpr std::size_t start_operand = 0;
+    static constexpr std::size_t step_size_operand = 1;
+    static constexpr std::size_t reached_operand = 2;
+
+    // the T add_numbers / subtract_numbers was called with
+    const std::type_info* type;
+    checked_operation operation;
+    overflow_status status;
+    // which step, counting from 0, did not fit, out of how many were asked for
+    unsigned long long step;
+    unsigned long long steps;
+    // start, increment (or decrement) and the value reached before the step that did not fit
+    alignas(long double) unsigned char operands[3][sizeof(long double)];
+    // writes the same message add_numbers / subtract_numbers used to print, for this event's T
+    void (*write_message)(std::ostream& output, const overflow_event& event);
+
+    template <typename T>
+    T operand(std::size_t index) const
+    {
+        assert(*type == typeid(T));
+
+        T value;
+        std::memcpy(&value, operands[index], sizeof(T));
+        return value;
+    }
+};
+
+/// <summary>
+/// Write a number the way the tests print them with the unary '+' (so chars come out as numbers).
+/// 128 bit integers have no stream operator, so they are turned into digits here.
+/// </summary>
+template <typename T>
+void write_number(std::ostream& output, T const& value)
+{
+    if constexpr (is_integer_type<T> && sizeof(T) > sizeof(unsigned long long)) {
+        using U = typename unsigned_of<T>::type;
+
+        // peel off digits from the magnitude, which for the lowest value only fits in the unsigned type
+        U magnitude = is_negative(value) ? static_cast<U>(U(0) - static_cast<U>(value)) : static_cast<U>(value);
+        char digits[48];
+        char* first = digits + sizeof(digits);
+        do {
+            *--first = static_cast<char>('0' + static_cast<int>(magnitude % 10));
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (is_negative(value)) {
+            *--first = '-';
+        }
+
+        output.write(first, digits + sizeof(digits) - first);
+    }
+    else {
+        output << +value;
+    }
+}
+
+/// <summary>
+/// The console message for an overflow_event of type T, worded as add_numbers / subtract_numbers always printed it
+/// </summary>
+template <typename T>
+void write_overflow_message(std::ostream& output, const overflow_event& event)
+{
+    const T step_size = event.operand<T>(overflow_event::step_size_operand);
+    const T reached = event.operand<T>(overflow_event::reached_operand);
+    const bool adding = event.operation == checked_operation::add;
+
+    output << (event.status == overflow_status::overflow ? "Overflow" : "Underflow") << " detected! Cannot " << (adding ? "add " : "subtract ");
+    write_number(output, step_size);
+    output << (adding ? " to " : " from ");
+    write_number(output, reached);
+    output << ", please consider using a different data type." << std::endl;
+}
+
+/// <summary>
+/// Fixed size queue of overflow events for one thread. Only the owning thread pushes and only one drain runs at a time,
+/// so the two ends are plain atomics: no locks, and a push is a few stores.
+/// </summary>
+class overflow_event_ring
+{
+public:
+    // a power of two, so the indexes can run freely and be masked down to a slot
+    static constexpr std::size_t capacity = 1024;
+
+    /// <summary>
+    /// The slot for the owning thread's next event, filled in place and then made visible with publish().
+    /// When the ring is full the event is counted as dropped instead, so a thread that is never drained
+    /// costs nothing but the count.
+    /// </summary>
+    /// <returns>the slot to fill, or nullptr if the ring is full</returns>
+    overflow_event* claim()
+    {
+        const std::size_t write = head.load(std::memory_order_relaxed);
+        if (write - tail.load(std::memory_order_acquire) == capacity) {
+            // only the owning thread writes the count, so it needs no read-modify-write
+            dropped_events.store(dropped_events.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        return &events[write & (capacity - 1)];
+    }
+
+    /// <summary>
+    /// Hand the slot from claim() over to the next drain
+    /// </summary>
+    void publish()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Hand every event pushed so far to visit, oldest first, and free their slots
+    /// </summary>
+    /// <returns>how many events were drained</returns>
+    template <typename Visitor>
+    std::size_t drain(Visitor&& visit)
+    {
+        const std::size_t read = tail.load(std::memory_order_relaxed);
+        const std::size_t written = head.load(std::memory_order_acquire);
+
+        for (std::size_t i = read; i != written; ++i)
+        {
+            visit(events[i & (capacity - 1)]);
+        }
+
+        tail.store(written, std::memory_order_release);
+        return written - read;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    unsigned long long dropped() const
+    {
+        return dropped_events.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::array<overflow_event, capacity> events;
+    // the ends sit on their own cache lines so the owning thread and a drain do not fight over one
+    alignas(64) std::atomic<std::size_t> head{ 0 };
+    alignas(64) std::atomic<std::size_t> tail{ 0 };
+    std::atomic<unsigned long long> dropped_events{ 0 };
+};
+
+/// <summary>
+/// Every thread's ring, so a drain can reach events from threads that have since finished.
+/// The mutex is only taken the first time a thread records an event, and by drains.
+/// </summary>
+struct overflow_event_registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<overflow_event_ring>> rings;
+    // dropped counts of rings already removed from the registry
+    unsigned long long retired_dropped = 0;
+};
+
+static overflow_event_registry& overflow_events()
+{
+    static overflow_event_registry registry;
+    return registry;
+}
+
+/// <summary>
+/// The calling thread's ring, registered on first use
+/// </summary>
+static overflow_event_ring& this_thread_overflow_events()
+{
+    thread_local const std::shared_ptr<overflow_event_ring> ring = []()
+    {
+        auto created = std::make_shared<overflow_event_ring>();
+
+        overflow_event_registry& registry = overflow_events();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.rings.push_back(created);
+        return created;
+    }();
+
+    return *ring;
+}
+
+/// <summary>
+/// Record that add_numbers / subtract_numbers ran out of range, to be reported by the next drain_overflow_events
+/// </summary>
+template <typename T>
+OVERFLOW_COLD void record_overflow_event(checked_operation operation, checked_result<T> const& checked, T const& start, T const& step_size, unsigned long int steps)
+{
+    overflow_event_ring& ring = this_thread_overflow_events();
+
+    overflow_event* event = ring.claim();
+    if (event == nullptr) {
+        return;
+    }
+
+    event->type = &typeid(T);
+    event->operation = operation;
+    event->status = checked.status;
+    event->step = checked.step;
+    event->steps = steps;
+    std::memcpy(event->operands[overflow_event::start_operand], &start, sizeof(T));
+    std::memcpy(event->operands[overflow_event::step_size_operand], &step_size, sizeof(T));
+    std::memcpy(event->operands[overflow_event::reached_operand], &checked.reached, sizeof(T));
+    event->write_message = write_overflow_message<T>;
+
+    ring.publish();
+}
+
+/// <summary>
+/// Hand every recorded overflow event, from every thread, to visit. Events from one thread arrive in the order they
+/// happened. Rings of threads that have finished are let go once they are empty.
+/// </summary>
+/// <returns>how many events were drained</returns>
+std::size_t drain_overflow_events(const std::function<void(const overflow_event&)>& visit)
+{
+    overflow_event_registry& registry = overflow_events();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::size_t drained = 0;
+    for (auto ring = registry.rings.begin(); ring != registry.rings.end();)
+    {
+        drained += (*ring)->drain(visit);
+
+        // the registry holding the only reference means the thread that owned the ring has finished
+        if (ring->use_count() == 1 && (*ring)->empty()) {
+            registry.retired_dropped += (*ring)->dropped();
+            ring = registry.rings.erase(ring);
+        }
+        else {
+            ++ring;
+        }
+    }
+
+    return drained;
+}
+
+/// <summary>
+/// Write the message for every recorded overflow event, as add_numbers / subtract_numbers used to print them
+/// </summary>
+/// <returns>how many events were drained</returns>
+std::size_t drain_overflow_events(std::ostream& output)
+{
+    return drain_overflow_events([&output](const overflow_event& event) { event.write_message(output, event); });
+}
+
+/// <summary>
+/// Hand every overflow event the calling thread has recorded to visit, oldest first, leaving other threads' events
+/// for their own drains
+/// </summary>
+/// <returns>how many events were drained</returns>
+std::size_t drain_this_thread_overflow_events(const std::function<void(const overflow_event&)>& visit)
+{
+    // looked up before locking, as a thread's first lookup registers its ring under the same mutex
+    overflow_event_ring& ring = this_thread_overflow_events();
+
+    // a ring allows only one drain at a time, so this still takes turns with drain_overflow_events
+    overflow_event_registry& registry = overflow_events();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+
+    return ring.drain(visit);
+}
+
+/// <summary>
+/// Write the message for every overflow event the calling thread has recorded, leaving other threads' events for
+/// their own drains. Lets concurrent tests each report their own overflows.
+/// </summary>
+/// <returns>how many events were drained</returns>
+std::size_t drain_this_thread_overflow_events(std::ostream& output)
+{
+    return drain_this_thread_overflow_events([&output](const overflow_event& event) { event.write_message(output, event); });
+}
+
+/// <summary>
+/// How many overflow events were lost because a thread's ring was full
+/// </summary>
+unsigned long long dropped_overflow_events()
+{
+    overflow_event_registry& registry = overflow_events();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+
+    unsigned long long dropped = registry.retired_dropped;
+    for (const auto& ring : registry.rings)
+    {
+        dropped += ring->dropped();
+    }
+    return dropped;
+}
+
+/// <summary>
+/// Template function to abstract away the logic of:
+///   start + (increment * steps)
+/// Computed in constant time. If the loop this replaces would have overflowed part way through, the same saturated value
+/// is returned and an overflow_event is recorded for drain_overflow_events to report (with the same message the loop
+/// printed), so nothing is written to the console here.
+/// </summary>
+/// <typeparam name="T">A type that with basic math functions</typeparam>
+/// <param name="start">The number to start with</param>
+/// <param name="increment">How much to add each step</param>
+/// <param name="steps">The number of steps to iterate</param>
+/// <returns>start + (increment * steps)</returns>
+template <typename T>
+T add_numbers(T const& start, T const& increment, unsigned long int const& steps)
+{
+    const checked_result<T> checked = checked_add_numbers(start, increment, steps);
+
+    if (checked.status != overflow_status::none) [[unlikely]] {
+        record_overflow_event(checked_operation::add, checked, start, increment, steps);
+    }
+
+    return checked.value;
+}
+
+/// <summary>
+/// Template function to abstract away the logic of:
+///   start - (increment * steps)
+/// Computed in constant time. As with the loop this replaces, a subtraction that would take the result below zero is
+/// reported as an underflow (for signed types too) and the lowest value is returned. A negative decrement moves the
+/// result up instead, and is reported as an overflow if it would pass the max value. Reports are recorded as
+/// overflow_events for drain_overflow_events, as with add_numbers.
+/// </summary>
+/// <typeparam name="T">A type that with basic math functions</typeparam>
+/// <param name="start">The number to start with</param>
+/// <param name="increment">How much to subtract each step</param>
+/// <param name="steps">The number of steps to iterate</param>
+/// <returns>start - (increment * steps)</returns>
+
+template <typename T>
+T subtract_numbers(T const& start, T const& decrement, unsigned long int const& steps)
+{
+    const checked_result<T> checked = checked_subtract_numbers(start, decrement, steps);
+
+    if (checked.status != overflow_status::none) [[unlikely]] {
+        record_overflow_event(checked_operation::subtract, checked, start, decrement, steps);
+    }
+
+    return checked.value;
+}
+
+/// <summary>
+/// Compile time version of test_overflow and test_underflow: the same inputs for T must give the same answers
+/// the console tests print, checked by the static_asserts below.
+/// </summary>
+template <typename T>
+constexpr bool checked_numbers_pass_tests()
+{
+    const unsigned long int steps = 5;
+    const T step_size = std::numeric_limits<T>::max() / steps;
+
+    // adding up from 0 fits for 5 steps and overflows on the 6th, which starts from the 5 step answer
+    const checked_result<T> added = checked_add_numbers<T>(0, step_size, steps);
+    const checked_result<T> add_overflow = checked_add_numbers<T>(0, step_size, steps + 1);
+    const bool add_passes = added.status == overflow_status::none
+        && added.value <= std::numeric_limits<T>::max() && added.value > std::numeric_limits<T>::max() - step_size
+        && add_overflow.status == overflow_status::overflow
+        && add_overflow.value == std::numeric_limits<T>::max()
+        && add_overflow.reached == added.value;
+
+    // subtracting down from max fits for 5 steps and goes below zero on the 6th, which starts from the 5 step answer
+    const checked_result<T> subtracted = checked_subtract_numbers<T>(std::numeric_limits<T>::max(), step_size, steps);
+    const checked_result<T> subtract_underflow = checked_subtract_numbers<T>(std::numeric_limits<T>::max(), step_size, steps + 1);
+    const bool subtract_passes = subtracted.status == overflow_status::none
+        && subtracted.value >= 0 && subtracted.value < step_size
+        && subtract_underflow.status == overflow_status::underflow
+        && subtract_underflow.value == std::numeric_limits<T>::lowest()
+        && subtract_underflow.reached == subtracted.value;
+
+    // and the same answers past the replayed loop, where real numbers switch to the analytic check
+    const unsigned long int long_run = 100;
+    const T small_step = std::numeric_limits<T>::max() / long_run;
+    const bool long_run_passes = checked_add_numbers<T>(0, small_step, long_run - 1).status == overflow_status::none
+        && checked_add_numbers<T>(std::numeric_limits<T>::max() / 2, small_step, long_run).status == overflow_status::overflow
+        && checked_subtract_numbers<T>(small_step, small_step, long_run).status == overflow_status::underflow;
+
+    return add_passes && subtract_passes && long_run_passes;
+}
+
+// signed integers
+static_assert(checked_numbers_pass_tests<char>(), "char overflow checks");
+static_assert(checked_numbers_pass_tests<wchar_t>(), "wchar_t overflow checks");
+static_assert(checked_numbers_pass_tests<short int>(), "short int overflow checks");
+static_assert(checked_numbers_pass_tests<int>(), "int overflow checks");
+static_assert(checked_numbers_pass_tests<long>(), "long overflow checks");
+static_assert(checked_numbers_pass_tests<long long>(), "long long overflow checks");
+
+// unsigned integers
+static_assert(checked_numbers_pass_tests<unsigned char>(), "unsigned char overflow checks");
+static_assert(checked_numbers_pass_tests<unsigned short int>(), "unsigned short int overflow checks");
+static_assert(checked_numbers_pass_tests<unsigned int>(), "unsigned int overflow checks");
+static_assert(checked_numbers_pass_tests<unsigned long>(), "unsigned long overflow checks");
+static_assert(checked_numbers_pass_tests<unsigned long long>(), "unsigned long long overflow checks");
+
+// real numbers
+static_assert(checked_numbers_pass_tests<float>(), "float overflow checks");
+static_assert(checked_numbers_pass_tests<double>(), "double overflow checks");
+static_assert(checked_numbers_pass_tests<long double>(), "long double overflow checks");
+
+/// <summary>
+/// One saturating step: a + b, or a - b when subtracting, clamped to the range of T instead of wrapping.
+/// Unlike subtract_numbers, a signed subtraction is allowed to go below zero and only saturates at the lowest value.
+/// </summary>
+/// <param name="saturated">set to whether the result had to be clamped</param>
+/// <returns>the clamped result</returns>
+template <typename T, bool Subtract>
+constexpr T saturating_step(T const& a, T const& b, bool& saturated)
+{
+    T result{};
+#if defined(__GNUC__) || defined(__clang__)
+    saturated = Subtract ? __builtin_sub_overflow(a, b, &result) : __builtin_add_overflow(a, b, &result);
+#else
+    if constexpr (Subtract) {
+        saturated = is_negative(b) ? a > std::numeric_limits<T>::max() + b : a < std::numeric_limits<T>::lowest() + b;
+        result = saturated ? T(0) : static_cast<T>(a - b);
+    }
+    else {
+        saturated = is_negative(b) ? a < std::numeric_limits<T>::lowest() - b : a > std::numeric_limits<T>::max() - b;
+        result = saturated ? T(0) : static_cast<T>(a + b);
+    }
+#endif
+    if (saturated) {
+        // Logic is: the sign of b says which way the result was heading, and subtracting flips it
+        result = (is_negative(b) != Subtract) ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+    }
+    return result;
+}
+
+/// <summary>
+/// a * b clamped to the range of T instead of wrapping
+/// </summary>
+/// <param name="saturated">set to whether the result had to be clamped</param>
+/// <returns>the clamped result</returns>
+template <typename T>
+constexpr T saturating_multiply(T const& a, T const& b, bool& saturated)
+{
+    T result{};
+#if defined(__GNUC__) || defined(__clang__)
+    saturated = __builtin_mul_overflow(a, b, &result);
+#else
+    // Logic is: a * b fits if |a| is no more than the limit (in the direction of the product) divided by |b|
+    if (a == 0 || b == 0) {
+        saturated = false;
+    }
+    else if (!is_negative(a)) {
+        saturated = !is_negative(b) ? a > std::numeric_limits<T>::max() / b : b < std::numeric_limits<T>::lowest() / a;
+    }
+    else {
+        saturated = !is_negative(b) ? a < std::numeric_limits<T>::lowest() / b : b < std::numeric_limits<T>::max() / a;
+    }
+    result = saturated ? T(0) : static_cast<T>(a * b);
+#endif
+    if (saturated) {
+        result = (is_negative(a) != is_negative(b)) ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+    }
+    return result;
+}
+
+#if defined(OVERFLOW_HAS_AVX2)
+/// <summary>
+/// ask the CPU (and OS, for the wider register state) whether AVX2 can be used
+/// </summary>
+static bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+    int registers[4];
+
+    __cpuid(registers, 0);
+    if (registers[0] < 7) {
+        return false;
+    }
+
+    // AVX (bit 28) and OSXSAVE (bit 27), then make sure the OS saves the YMM registers
+    __cpuid(registers, 1);
+    const int avx_bits = (1 << 27) | (1 << 28);
+    if ((registers[2] & avx_bits) != avx_bits || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    // AVX2 is bit 5 of EBX on leaf 7
+    __cpuidex(registers, 7, 0);
+    return (registers[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+/// <summary>
+/// Squeeze a _mm256_movemask_epi8 of 16 bit lanes (two identical bits per lane) down to one bit per lane
+/// </summary>
+static inline std::uint32_t compress_lane_pairs(std::uint32_t bits)
+{
+    bits &= 0x55555555u;
+    bits = (bits | (bits >> 1)) & 0x33333333u;
+    bits = (bits | (bits >> 2)) & 0x0F0F0F0Fu;
+    bits = (bits | (bits >> 4)) & 0x00FF00FFu;
+    bits = (bits | (bits >> 8)) & 0x0000FFFFu;
+    return bits;
+}
+
+/// <summary>
+/// One register's worth of saturating_step. 8 and 16 bit lanes use the hardware saturating instructions and find the
+/// clamped lanes by comparing against the wrapping result, 32 and 64 bit lanes have no saturating instructions so the
+/// overflow is detected with compares (unsigned) or sign bit tests (signed) and the limit is blended in.
+/// </summary>
+/// <param name="saturated_bits">one bit per lane, set where the lane was clamped</param>
+template <std::size_t Width, bool Signed, bool Subtract>
+OVERFLOW_TARGET_AVX2
+static inline __m256i saturating_lanes_avx2(__m256i a, __m256i b, std::uint32_t& saturated_bits)
+{
+    if constexpr (Width == 1 || Width == 2) {
+        __m256i clamped;
+        __m256i wrapped;
+        if constexpr (Width == 1) {
+            if constexpr (Signed) {
+                clamped = Subtract ? _mm256_subs_epi8(a, b) : _mm256_adds_epi8(a, b);
+            }
+            else {
+                clamped = Subtract ? _mm256_subs_epu8(a, b) : _mm256_adds_epu8(a, b);
+            }
+            wrapped = Subtract ? _mm256_sub_epi8(a, b) : _mm256_add_epi8(a, b);
+            saturated_bits = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(clamped, wrapped)));
+        }
+        else {
+            if constexpr (Signed) {
+                clamped = Subtract ? _mm256_subs_epi16(a, b) : _mm256_adds_epi16(a, b);
+            }
+            else {
+                clamped = Subtract ? _mm256_subs_epu16(a, b) : _mm256_adds_epu16(a, b);
+            }
+            wrapped = Subtract ? _mm256_sub_epi16(a, b) : _mm256_add_epi16(a, b);
+            saturated_bits = compress_lane_pairs(~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(clamped, wrapped))));
+        }
+        return clamped;
+    }
+    else if constexpr (Width == 4) {
+        const __m256i wrapped = Subtract ? _mm256_sub_epi32(a, b) : _mm256_add_epi32(a, b);
+        if constexpr (Signed) {
+            // Logic is: overflow happened when the result's sign disagrees with what the operands allow,
+            // and the limit it hit is max for a non-negative a and lowest for a negative one
+            const __m256i overflow = Subtract
+                ? _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, wrapped))
+                : _mm256_and_si256(_mm256_xor_si256(a, wrapped), _mm256_xor_si256(b, wrapped));
+            const __m256i limit = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(std::numeric_limits<std::int32_t>::max()));
+            saturated_bits = static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(overflow)));
+            return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(wrapped), _mm256_castsi256_ps(limit), _mm256_castsi256_ps(overflow)));
+        }
+        else {
+            // Logic is: a + b wrapped if it came out smaller than a, a - b wrapped if b was bigger than a
+            const __m256i in_range = Subtract
+                ? _mm256_cmpeq_epi32(_mm256_max_epu32(a, b), a)
+                : _mm256_cmpeq_epi32(_mm256_max_epu32(a, wrapped), wrapped);
+            const __m256i overflow = _mm256_xor_si256(in_range, _mm256_set1_epi32(-1));
+            saturated_bits = static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(overflow)));
+            return Subtract ? _mm256_andnot_si256(overflow, wrapped) : _mm256_or_si256(wrapped, overflow);
+        }
+    }
+    else {
+        static_assert(Width == 8, "saturating_lanes_avx2 handles 1, 2, 4 and 8 byte lanes");
+
+        const __m256i wrapped = Subtract ? _mm256_sub_epi64(a, b) : _mm256_add_epi64(a, b);
+        if constexpr (Signed) {
+            const __m256i overflow = Subtract
+                ? _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, wrapped))
+                : _mm256_and_si256(_mm256_xor_si256(a, wrapped), _mm256_xor_si256(b, wrapped));
+            // there is no 64 bit arithmetic shift in AVX2, so the sign of a comes from a compare instead
+            const __m256i a_negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), a);
+            const __m256i limit = _mm256_xor_si256(a_negative, _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::max()));
+            saturated_bits = static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(overflow)));
+            return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(wrapped), _mm256_castsi256_pd(limit), _mm256_castsi256_pd(overflow)));
+        }
+        else {
+            // AVX2 only has a signed 64 bit compare, flipping the top bit turns it into an unsigned one
+            const __m256i bias = _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min());
+            const __m256i overflow = Subtract
+                ? _mm256_cmpgt_epi64(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias))
+                : _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), _mm256_xor_si256(wrapped, bias));
+            saturated_bits = static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(overflow)));
+            return Subtract ? _mm256_andnot_si256(overflow, wrapped) : _mm256_or_si256(wrapped, overflow);
+        }
+    }
+}
+
+/// <summary>
+/// AVX2 kernel for saturating_batch, 32 bytes of each input per step. Stops at the last full register.
+/// </summary>
+/// <returns>how many elements were processed</returns>
+template <typename T, bool Subtract>
+OVERFLOW_TARGET_AVX2
+static std::size_t saturating_batch_avx2(const T* a, const T* b, T* results, std::uint64_t* overflow_mask, std::size_t count)
+{
+    constexpr std::size_t lanes = 32 / sizeof(T);
+
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes)
+    {
+        const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+
+        std::uint32_t saturated_bits;
+        const __m256i clamped = saturating_lanes_avx2<sizeof(T), is_signed_type<T>, Subtract>(left, right, saturated_bits);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(results + i), clamped);
+
+        // lanes divides 64 and i is a multiple of lanes, so each register's bits land inside one mask word
+        overflow_mask[i / 64] |= static_cast<std::uint64_t>(saturated_bits) << (i % 64);
+    }
+
+    return i;
+}
+#endif
+
+/// <summary>
+/// Number of 64 bit words an overflow mask needs to cover count elements
+/// </summary>
+constexpr std::size_t overflow_mask_words(std::size_t count)
+{
+    return (count + 63) / 64;
+}
+
+/// <summary>
+/// Shared body of saturating_add_batch and saturating_subtract_batch
+/// </summary>
+template <typename T, bool Subtract>
+std::size_t saturating_batch(std::span<const T> a, std::span<const T> b, std::span<T> results, std::span<std::uint64_t> overflow_mask)
+{
+    static_assert(is_integer_type<T> && !std::is_same<T, bool>::value, "saturating batches are for integer counters");
+
+    // assert that our input data is good
+    const std::size_t count = a.size();
+    assert(b.size() == count);
+    assert(results.size() == count);
+    assert(overflow_mask.size() >= overflow_mask_words(count));
+
+    std::fill_n(overflow_mask.begin(), overflow_mask_words(count), std::uint64_t(0));
+
+    std::size_t i = 0;
+#if defined(OVERFLOW_HAS_AVX2)
+    static const bool use_avx2 = cpu_supports_avx2();
+    if constexpr (sizeof(T) <= 8) {
+        if (use_avx2) {
+            i = saturating_batch_avx2<T, Subtract>(a.data(), b.data(), results.data(), overflow_mask.data(), count);
+        }
+    }
+#endif
+
+    // finish whatever is left over that does not fill a full register (or everything, without AVX2)
+    for (; i < count; ++i)
+    {
+        bool saturated;
+        results[i] = saturating_step<T, Subtract>(a[i], b[i], saturated);
+        overflow_mask[i / 64] |= static_cast<std::uint64_t>(saturated) << (i % 64);
+    }
+
+    std::size_t saturated_count = 0;
+    for (std::size_t word = 0; word < overflow_mask_words(count); ++word)
+    {
+        saturated_count += static_cast<std::size_t>(std::popcount(overflow_mask[word]));
+    }
+    return saturated_count;
+}
+
+/// <summary>
+/// Apply a whole batch of counter updates at once: results[i] = starts[i] + increments[i], saturated at the limits of T
+/// instead of overflowing. Nothing is printed, each clamped element is flagged in overflow_mask instead.
+/// </summary>
+/// <typeparam name="T">An integer type</typeparam>
+/// <param name="starts">The numbers to start with</param>
+/// <param name="increments">How much to add to each one (same length as starts)</param>
+/// <param name="results">Where to write the sums (same length as starts, may be the same span as starts)</param>
+/// <param name="overflow_mask">Bit i % 64 of word i / 64 is set if element i saturated, needs overflow_mask_words(starts.size()) words</param>
+/// <returns>How many elements saturated</returns>
+template <typename T>
+std::size_t saturating_add_batch(std::span<const T> starts, std::span<const T> increments, std::span<T> results, std::span<std::uint64_t> overflow_mask)
+{
+    return saturating_batch<T, false>(starts, increments, results, overflow_mask);
+}
+
+/// <summary>
+/// Apply a whole batch of counter updates at once: results[i] = starts[i] - decrements[i], saturated at the limits of T
+/// instead of underflowing. Nothing is printed, each clamped element is flagged in overflow_mask instead.
+/// </summary>
+/// <typeparam name="T">An integer type</typeparam>
+/// <param name="starts">The numbers to start with</param>
+/// <param name="decrements">How much to subtract from each one (same length as starts)</param>
+/// <param name="results">Where to write the differences (same length as starts, may be the same span as starts)</param>
+/// <param name="overflow_mask">Bit i % 64 of word i / 64 is set if element i saturated, needs overflow_mask_words(starts.size()) words</param>
+/// <returns>How many elements saturated</returns>
+template <typename T>
+std::size_t saturating_subtract_batch(std::span<const T> starts, std::span<const T> decrements, std::span<T> results, std::span<std::uint64_t> overflow_mask)
+{
+    return saturating_batch<T, true>(starts, decrements, results, overflow_mask);
+}
+
+#if defined(__SIZEOF_INT128__)
+// 128 bit counters are wider than an AVX2 lane and take the scalar path, instantiated here so they keep compiling
+template std::size_t saturating_add_batch<__int128>(std::span<const __int128>, std::span<const __int128>, std::span<__int128>, std::span<std::uint64_t>);
+template std::size_t saturating_subtract_batch<unsigned __int128>(std::span<const unsigned __int128>, std::span<const unsigned __int128>, std::span<unsigned __int128>, std::span<std::uint64_t>);
+#endif
+
+/// <summary>
+/// The calculation as words for an error message, in the same form as the add_numbers messages (e.g. "add 1 to 127")
+/// </summary>
+template <typename T, typename Operand>
+std::string describe_checked_operation(checked_operation operation, T const& left, Operand const& right)
+{
+    // write_number rather than std::to_string, which has no overload for the 128 bit integers
+    const auto as_text = [](auto const& value) {
+        std::ostringstream text;
+        write_number(text, value);
+        return text.str();
+    };
+    const std::string left_text = as_text(left);
+    const std::string right_text = as_text(right);
+
+    switch (operation)
+    {
+    case checked_operation::add:
+        return "add " + right_text + " to " + left_text;
+    case checked_operation::subtract:
+        return "subtract " + right_text + " from " + left_text;
+    case checked_operation::multiply:
+        return "multiply " + left_text + " by " + right_text;
+    case checked_operation::divide:
+        return "divide " + left_text + " by " + right_text;
+    case checked_operation::shift_left:
+        return "shift " + left_text + " left by " + right_text;
+    case checked_operation::shift_right:
+        return "shift " + left_text + " right by " + right_text;
+    }
+    return left_text + " ? " + right_text;
+}
+
+/// <summary>
+/// Overflow policy for checked: clamp to the limit the result was heading past, as add_numbers does
+/// </summary>
+struct saturate_on_overflow
+{
+    template <typename T, typename Operand>
+    constexpr T on_overflow(overflow_status, T const& saturated, checked_operation, T const&, Operand const&) const
+    {
+        return saturated;
+    }
+
+    constexpr void combine(saturate_on_overflow const&) {}
+};
+
+/// <summary>
+/// Throw the exception for throw_on_overflow. Which limit the result saturated to says whether it was an overflow or
+/// an underflow, working that out here rather than in the caller keeps the caller's overflow test a single branch.
+/// </summary>
+template <typename T, typename Operand>
+[[noreturn]] OVERFLOW_COLD void throw_checked_error(bool invalid, T saturated, checked_operation operation, T left, Operand right)
+{
+    const std::string calculation = describe_checked_operation(operation, left, right);
+
+    if (invalid) {
+        throw std::domain_error("Invalid operation! Cannot " + calculation + ".");
+    }
+    if (saturated != std::numeric_limits<T>::max()) {
+        throw std::underflow_error("Underflow detected! Cannot " + calculation + ", please consider using a different data type.");
+    }
+    throw std::overflow_error("Overflow detected! Cannot " + calculation + ", please consider using a different data type.");
+}
+
+/// <summary>
+/// Overflow policy for checked: throw std::overflow_error / std::underflow_error (std::domain_error for a division by zero
+/// or a negative shift) and leave the value as it was
+/// </summary>
+struct throw_on_overflow
+{
+    template <typename T, typename Operand>
+    T on_overflow(overflow_status status, T const& saturated, checked_operation operation, T const& left, Operand const& right) const
+    {
+        throw_checked_error(status == overflow_status::invalid, saturated, operation, left, right);
+    }
+
+    constexpr void combine(throw_on_overflow const&) {}
+};
+
+/// <summary>
+/// Overflow policy for checked: saturate, and remember that it happened so it can be reported later with overflowed()
+/// </summary>
+class flag_on_overflow
+{
+public:
+    template <typename T, typename Operand>
+    constexpr T on_overflow(overflow_status, T const& saturated, checked_operation, T const&, Operand const&)
+    {
+        flagged = true;
+        return saturated;
+    }
+
+    // a value worked out from a flagged value is flagged too
+    constexpr void combine(flag_on_overflow const& other)
+    {
+        flagged = flagged || other.flagged;
+    }
+
+    /// <summary>
+    /// Whether any calculation leading to this value ran out of range
+    /// </summary>
+    constexpr bool overflowed() const
+    {
+        return flagged;
+    }
+
+    constexpr void clear_overflow()
+    {
+        flagged = false;
+    }
+
+private:
+    bool flagged = false;
+};
+
+/// <summary>
+/// An integer that checks its own arithmetic, for counters that should never silently wrap.
+/// +, -, * and / use the same overflow detection as add_numbers / subtract_numbers (one step at a time), and shifts are
+/// checked as multiplying / dividing by a power of two. What happens on overflow is up to the policy: saturate_on_overflow
+/// (the default), throw_on_overflow or flag_on_overflow. While nothing overflows the only cost over a plain T is the
+/// compiler's overflow flag test, and saturate / throw add nothing to its size.
+/// </summary>
+/// <typeparam name="T">An integer type</typeparam>
+/// <typeparam name="Policy">What to do when a result does not fit in T</typeparam>
+template <typename T, typename Policy = saturate_on_overflow>
+class checked : public Policy
+{
+    static_assert(is_integer_type<T> && !std::is_same<T, bool>::value, "checked is for integer types");
+
+public:
+    constexpr checked() = default;
+
+    constexpr checked(T const& value) : current(value) {}
+
+    constexpr T value() const
+    {
+        return current;
+    }
+
+    constexpr explicit operator T() const
+    {
+        return current;
+    }
+
+    constexpr checked& operator+=(checked const& other)
+    {
+        Policy::combine(other);
+
+        bool saturated = false;
+        const T result = saturating_step<T, false>(current, other.current, saturated);
+        return settle(result, saturated, checked_operation::add, other.current);
+    }
+
+    constexpr checked& operator-=(checked const& other)
+    {
+        Policy::combine(other);
+
+        bool saturated = false;
+        const T result = saturating_step<T, true>(current, other.current, saturated);
+        return settle(result, saturated, checked_operation::subtract, other.current);
+    }
+
+    constexpr checked& operator*=(checked const& other)
+    {
+        Policy::combine(other);
+
+        bool saturated = false;
+        const T result = saturating_multiply(current, other.current, saturated);
+        return settle(result, saturated, checked_operation::multiply, other.current);
+    }
+
+    constexpr checked& operator/=(checked const& other)
+    {
+        Policy::combine(other);
+
+        // Logic is: dividing by zero has no answer (saturated towards the sign of the dividend), and in two's complement
+        // the lowest value divided by -1 is the only quotient too big for T
+        if (other.current == 0) [[unlikely]] {
+            const T toward = current == 0 ? T(0) : (is_negative(current) ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max());
+            current = Policy::on_overflow(overflow_status::invalid, toward, checked_operation::divide, current, other.current);
+            return *this;
+        }
+        if constexpr (is_signed_type<T>) {
+            if (current == std::numeric_limits<T>::lowest() && other.current == T(-1)) [[unlikely]] {
+                current = Policy::on_overflow(overflow_status::overflow, std::numeric_limits<T>::max(), checked_operation::divide, current, other.current);
+                return *this;
+            }
+        }
+
+        current = static_cast<T>(current / other.current);
+        return *this;
+    }
+
+    constexpr checked& operator<<=(int count)
+    {
+        if (count < 0) [[unlikely]] {
+            current = Policy::on_overflow(overflow_status::invalid, current, checked_operation::shift_left, current, count);
+            return *this;
+        }
+
+        // Logic is: shifting left multiplies by 2^count, which fit if shifting back gives the value we started with
+        // (done through the unsigned type, so negative values shift without undefined behaviour)
+        using U = typename unsigned_of<T>::type;
+        const bool fits = current == 0
+            || (count < std::numeric_limits<U>::digits
+                && static_cast<T>(static_cast<T>(static_cast<U>(static_cast<U>(current) << count)) >> count) == current);
+        if (!fits) [[unlikely]] {
+            const T saturated = is_negative(current) ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+            const overflow_status status = is_negative(current) ? overflow_status::underflow : overflow_status::overflow;
+            current = Policy::on_overflow(status, saturated, checked_operation::shift_left, current, count);
+            return *this;
+        }
+
+        if (current != 0) {
+            current = static_cast<T>(static_cast<U>(current) << count);
+        }
+        return *this;
+    }
+
+    constexpr checked& operator>>=(int count)
+    {
+        if (count < 0) [[unlikely]] {
+            current = Policy::on_overflow(overflow_status::invalid, current, checked_operation::shift_right, current, count);
+            return *this;
+        }
+
+        // Shifting right divides by 2^count (rounding down) and always fits, even when every bit is shifted out
+        if (count >= std::numeric_limits<typename unsigned_of<T>::type>::digits) {
+            current = is_negative(current) ? T(-1) : T(0);
+        }
+        else {
+            current = static_cast<T>(current >> count);
+        }
+        return *this;
+    }
+
+    constexpr checked& operator++()
+    {
+        return *this += checked(T(1));
+    }
+
+    constexpr checked& operator--()
+    {
+        return *this -= checked(T(1));
+    }
+
+    constexpr checked operator++(int)
+    {
+        const checked before = *this;
+        ++*this;
+        return before;
+    }
+
+    constexpr checked operator--(int)
+    {
+        const checked before = *this;
+        --*this;
+        return before;
+    }
+
+    friend constexpr checked operator+(checked left, checked const& right)
+    {
+        return left += right;
+    }
+
+    friend constexpr checked operator-(checked left, checked const& right)
+    {
+        return left -= right;
+    }
+
+    friend constexpr checked operator*(checked left, checked const& right)
+    {
+        return left *= right;
+    }
+
+    friend constexpr checked operator/(checked left, checked const& right)
+    {
+        return left /= right;
+    }
+
+    friend constexpr checked operator<<(checked left, int count)
+    {
+        return left <<= count;
+    }
+
+    friend constexpr checked operator>>(checked left, int count)
+    {
+        return left >>= count;
+    }
+
+    friend constexpr bool operator==(checked const& left, checked const& right)
+    {
+        return left.current == right.current;
+    }
+
+    friend constexpr auto operator<=>(checked const& left, checked const& right)
+    {
+        return left.current <=> right.current;
+    }
+
+private:
+    /// <summary>
+    /// Keep a result that fit, or hand one that did not to the policy along with which way it went out of range
+    /// </summary>
+    constexpr checked& settle(T const& result, bool saturated, checked_operation operation, T const& right)
+    {
+        if (saturated) [[unlikely]] {
+            const overflow_status status = result == std::numeric_limits<T>::max() ? overflow_status::overflow : overflow_status::underflow;
+            current = Policy::on_overflow(status, result, operation, current, right);
+            return *this;
+        }
+
+        current = result;
+        return *this;
+    }
+
+    T current{};
+};
+
+// saturating and throwing cost nothing in size over the plain integer
+static_assert(sizeof(checked<int>) == sizeof(int), "checked<int> should be the size of an int");
+static_assert(sizeof(checked<long long, throw_on_overflow>) == sizeof(long long), "checked<long long> should be the size of a long long");
+
+// and the checks work in constant expressions
+static_assert((checked<int>(std::numeric_limits<int>::max()) + 1).value() == std::numeric_limits<int>::max(), "checked add saturates");
+static_assert((checked<unsigned char>(3) - 4).value() == 0, "checked subtract saturates");
+static_assert((checked<short>(-300) * 300).value() == std::numeric_limits<short>::lowest(), "checked multiply saturates");
+static_assert((checked<int>(std::numeric_limits<int>::lowest()) / -1).value() == std::numeric_limits<int>::max(), "checked divide saturates");
+static_assert((checked<int>(1) << 30).value() == (1 << 30) && (checked<int>(1) << 31).value() == std::numeric_limits<int>::max(), "checked shift left saturates");
+static_assert((checked<int>(-5) >> 40).value() == -1, "checked shift right rounds down");
+static_assert((checked<int, flag_on_overflow>(std::numeric_limits<int>::max()) + 1 - 1).overflowed(), "checked flags stick");
+static_assert(!(checked<int, flag_on_overflow>(40) + 2).overflowed(), "checked flags only overflows");
+
+#if defined(__SIZEOF_INT128__)
+// including the 128 bit integers, which <type_traits> does not count as integers without compiler extensions
+static_assert((checked<__int128>(std::numeric_limits<__int128>::max()) + 1).value() == std::numeric_limits<__int128>::max(), "checked __int128 add saturates");
+static_assert((checked<unsigned __int128>(1) << 128).value() == std::numeric_limits<unsigned __int128>::max(), "checked unsigned __int128 shift left saturates");
+static_assert((checked<__int128>(-5) >> 200).value() == -1, "checked __int128 shift right rounds down");
+#endif
+
+
+//  NOTE:
+//    You will see the unary ('+') operator used in front of the variables in the test_XXX methods.
+//    This forces the output to be a number for cases where cout would assume it is a character. 
+
+template <typename T>
+void test_overflow()
+{
+    // START DO NOT CHANGE
+    //  how many times will we iterate
+    const unsigned long int steps = 5;
+    // how much will we add each step (result should be: start + (increment * steps))
+    const T increment = std::numeric_limits<T>::max() / steps;
+    // whats our starting point
+    const T start = 0;
+
+    std::cout << "Overflow Test of Type = " << typeid(T).name() << std::endl;
+    // END DO NOT CHANGE
+
+    std::cout << "\tAdding Numbers Without Overflow (" << +start << ", " << +increment << ", " << steps << ") = ";
+    T result = add_numbers<T>(start, increment, steps);
+    drain_overflow_events(std::cout);
+    std::cout << +result << std::endl;
+
+    std::cout << "\tAdding Numbers With Overflow (" << +start << ", " << +increment << ", " << (steps + 1) << ") = ";
+    result = add_numbers<T>(start, increment, steps + 1);
+    drain_overflow_events(std::cout);
+
+    // Check whether overflow occurred
+    // If result is returned as the max value, this means overflow was caught in add_numbers()
+    if (result == std::numeric_limits<T>::max()) {
+        return;
+    }
+    else {
+        std::cout << +result << std::endl;
+    }
+}
+
+template <typename T>
+void test_underflow()
+{
+    // START DO NOT CHANGE
+    //  how many times will we iterate
+    const unsigned long int steps = 5;
+    // how much will we subtract each step (result should be: start - (increment * steps))
+    const T decrement = std::numeric_limits<T>::max() / steps;
+    // whats our starting point
+    const T start = std::numeric_limits<T>::max();
+
+    std::cout << "Underflow Test of Type = " << typeid(T).name() << std::endl;
+    // END DO NOT CHANGE
+
+    std::cout << "\tSubtracting Numbers Without Underflow (" << +start << ", " << +decrement << ", " << steps << ") = ";
+    auto result = subtract_numbers<T>(start, decrement, steps);
+    drain_overflow_events(std::cout);
+    std::cout << +result << std::endl;
+
+    std::cout << "\tSubtracting Numbers With Underflow (" << +start << ", " << +decrement << ", " << (steps + 1) << ") = ";
+    result = subtract_numbers<T>(start, decrement, steps + 1);
+    drain_overflow_events(std::cout);
+
+    // Check whether underflow occurred
+    // If result is returned as the lowest value, this means underflow was caught in add_numbers()
+    if (result == std::numeric_limits<T>::lowest()) {
+        return;
+    }
+    else {
+        std::cout << +result << std::endl;
+    }
+}
+
+void do_overflow_tests(const std::string& star_line)
+{
+    std::cout << std::endl << star_line << std::endl;
+    std::cout << "*** Running Overflow Tests ***" << std::endl;
+    std::cout << star_line << std::endl;
+
+    // Testing C++ primative times see: https://www.geeksforgeeks.org/c-data-types/
+    // signed integers
+    test_overflow<char>();
+    test_overflow<wchar_t>();
+    test_overflow<short int>();
+    test_overflow<int>();
+    test_overflow<long>();
+    test_overflow<long long>();
+
+    // unsigned integers
+    test_overflow<unsigned char>();
+    test_overflow<unsigned short int>();
+    test_overflow<unsigned int>();
+    test_overflow<unsigned long>();
+    test_overflow<unsigned long long>();
+
+    // real numbers
+    test_overflow<float>();
+    test_overflow<double>();
+    test_overflow<long double>();
+}
+
+void do_underflow_tests(const std::string& star_line)
+{
+    std::cout << std::endl << star_line << std::endl;
+    std::cout << "*** Running Underflow Tests ***" << std::endl;
+    std::cout << star_line << std::endl;
+
+    // Testing C++ primative times see: https://www.geeksforgeeks.org/c-data-types/
+    // signed integers
+    test_underflow<char>();
+    test_underflow<wchar_t>();
+    test_underflow<short int>();
+    test_underflow<int>();
+    test_underflow<long>();
+    test_underflow<long long>();
+
+    // unsigned integers
+    test_underflow<unsigned char>();
+    test_underflow<unsigned short int>();
+    test_underflow<unsigned int>();
+    test_underflow<unsigned long>();
+    test_underflow<unsigned long long>();
+
+    // real numbers
+    test_underflow<float>();
+    test_underflow<double>();
+    test_underflow<long double>();
+}
+
+/// <summary>
+/// One test of the type sweep, writing to the stream it is given rather than std::cout
+/// </summary>
+struct sweep_test
+{
+    std::string name;
+    std::function<void(std::ostream&)> run;
+};
+
+/// <summary>
+/// What a sweep test wrote, and how long it took to write it
+/// </summary>
+struct sweep_result
+{
+    std::string output;
+    std::chrono::nanoseconds elapsed{};
+};
+
+/// <summary>
+/// test_overflow for any number of steps, written to output. Only the calling thread's overflow events are drained,
+/// so any number of these can run at once.
+/// </summary>
+template <typename T>
+void sweep_overflow(std::ostream& output, unsigned long int steps)
+{
+    const T increment = std::numeric_limits<T>::max() / steps;
+    const T start = 0;
+
+    output << "Overflow Test of Type = " << typeid(T).name() << '\n';
+
+    output << "\tAdding Numbers Without Overflow (";
+    write_number(output, start);
+    output << ", ";
+    write_number(output, increment);
+    output << ", " << steps << ") = ";
+    T result = add_numbers<T>(start, increment, steps);
+    drain_this_thread_overflow_events(output);
+    write_number(output, result);
+    output << '\n';
+
+    output << "\tAdding Numbers With Overflow (";
+    write_number(output, start);
+    output << ", ";
+    write_number(output, increment);
+    output << ", " << (steps + 1) << ") = ";
+    result = add_numbers<T>(start, increment, steps + 1);
+    drain_this_thread_overflow_events(output);
+    if (result != std::numeric_limits<T>::max()) {
+        write_number(output, result);
+        output << '\n';
+    }
+}
+
+/// <summary>
+/// test_underflow for any number of steps, written to output (see sweep_overflow)
+/// </summary>
+template <typename T>
+void sweep_underflow(std::ostream& output, unsigned long int steps)
+{
+    const T decrement = std::numeric_limits<T>::max() / steps;
+    const T start = std::numeric_limits<T>::max();
+
+    output << "Underflow Test of Type = " << typeid(T).name() << '\n';
+
+    output << "\tSubtracting Numbers Without Underflow (";
+    write_number(output, start);
+    output << ", ";
+    write_number(output, decrement);
+    output << ", " << steps << ") = ";
+    T result = subtract_numbers<T>(start, decrement, steps);
+    drain_this_thread_overflow_events(output);
+    write_number(output, result);
+    output << '\n';
+
+    output << "\tSubtracting Numbers With Underflow (";
+    write_number(output, start);
+    output << ", ";
+    write_number(output, decrement);
+    output << ", " << (steps + 1) << ") = ";
+    result = subtract_numbers<T>(start, decrement, steps + 1);
+    drain_this_thread_overflow_events(output);
+    if (result != std::numeric_limits<T>::lowest()) {
+        write_number(output, result);
+        output << '\n';
+    }
+}
+
+/// <summary>
+/// Add the overflow test of every type in Types, then the underflow test of every type, in the order given
+/// </summary>
+template <typename... Types>
+void add_sweep_tests(std::vector<sweep_test>& tests, unsigned long int steps)
+{
+    (tests.push_back({ std::string("Overflow ") + typeid(Types).name(), [steps](std::ostream& output) { sweep_overflow<Types>(output, steps); } }), ...);
+    (tests.push_back({ std::string("Underflow ") + typeid(Types).name(), [steps](std::ostream& output) { sweep_underflow<Types>(output, steps); } }), ...);
+}
+
+/// <summary>
+/// Run the tests on thread_count threads (the calling thread being one of them), each test into its own buffer.
+/// Logic is:
+///   each thread takes the next test not yet started until none are left, so slow types do not hold up the rest
+///   the results line up with tests, whichever thread ran each one and whenever it finished
+/// </summary>
+std::vector<sweep_result> run_sweep(const std::vector<sweep_test>& tests, unsigned thread_count)
+{
+    std::vector<sweep_result> results(tests.size());
+    std::atomic<std::size_t> next_test{ 0 };
+
+    auto work = [&tests, &results, &next_test]()
+    {
+        for (std::size_t index = next_test.fetch_add(1, std::memory_order_relaxed); index < tests.size();
+            index = next_test.fetch_add(1, std::memory_order_relaxed))
+        {
+            std::ostringstream output;
+            const auto start = std::chrono::steady_clock::now();
+            tests[index].run(output);
+            results[index].elapsed = std::chrono::steady_clock::now() - start;
+            results[index].output = output.str();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < thread_count && i < tests.size(); ++i)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    return results;
+}
 
 /// <summary>
-/// Template function to abstract away the logic of:
-///   start + (increment * steps)
+/// The overflow and underflow tests for every type of do_overflow_tests / do_underflow_tests, plus std::int8_t and
+/// (where the compiler has them) the 128 bit integers, at any step count and run concurrently. Output comes out in the
+/// same order every time, each test followed by how long it took.
 /// </summary>
-/// <typeparam name="T">A type that with basic math functions</typeparam>
-/// <param name="start">The number to start with</param>
-/// <param name="increment">How much to add each step</param>
-/// <param name="steps">The number of steps to iterate</param>
-/// <returns>start + (increment * steps)</returns>
-template <typename T>
-T add_numbers(T const& start, T const& increment, unsigned long int const& steps)
+void do_type_sweep(const std::string& star_line, unsigned long int steps, unsigned thread_count)
 {
-    T result = start;
+    std::vector<sweep_test> tests;
+    add_sweep_tests<char, wchar_t, short int, int, long, long long,
+        unsigned char, unsigned short int, unsigned int, unsigned long, unsigned long long,
+        float, double, long double,
+        std::int8_t
+#if defined(__SIZEOF_INT128__)
+        , __int128, unsigned __int128
+#endif
+    >(tests, steps);
 
-    for (unsigned long int i = 0; i < steps; ++i)
-    {
-        // Check for overflow before adding next increment
-        // Logic is: if the result is greater than the max value minus the increment, then one more increment will overflow
-        if (result > std::numeric_limits<T>::max() - increment) {
-            std::cout << "Overflow detected! Cannot add " << +increment << " to " << +result << ", please consider using a different data type." << std::endl;
+    std::cout << std::endl << star_line << std::endl;
+    std::cout << "*** Running Type Sweep (" << tests.size() << " tests, " << steps << " steps, " << thread_count << " threads) ***" << std::endl;
+    std::cout << star_line << std::endl;
 
-            return std::numeric_limits<T>::max();  // Break the loop
-        }
-        // If no overflow is detected, addition can continue safely
-        else {
-            result += increment;
-        }
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<sweep_result> results = run_sweep(tests, thread_count);
+    const std::chrono::duration<double, std::micro> wall = std::chrono::steady_clock::now() - start;
+
+    std::chrono::duration<double, std::micro> busy{};
+    for (const sweep_result& result : results)
+    {
+        const std::chrono::duration<double, std::micro> elapsed = result.elapsed;
+        busy += elapsed;
+        std::cout << result.output << "\tTook " << std::fixed << std::setprecision(1) << elapsed.count() << " us" << std::endl;
     }
 
-    // Return the result after incrementing is complete, i.e. no overflow occurred
-    return result;
+    std::cout << std::endl << "Type sweep took " << wall.count() << " us (" << busy.count() << " us across tests)" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
 }
 
+// The fuzzer checks integers against the same sums worked out in a type wide enough that nothing can overflow.
+// step size * steps needs both widths together, so types too wide for that (the 128 bit integers) are left to the type sweep.
+#if defined(__SIZEOF_INT128__)
+using fuzz_wide_int = __int128;
+using fuzz_wide_unsigned = unsigned __int128;
+#else
+using fuzz_wide_int = long long;
+using fuzz_wide_unsigned = unsigned long long;
+#endif
+
+// cases per shard of the fuzz (each shard is one job for the sweep's workers), and how many mismatches of each shard are written out
+constexpr std::size_t fuzz_shard_cases = std::size_t(1) << 16;
+constexpr unsigned fuzz_reported_mismatches = 3;
+
+// step counts up to this are a short run, where the real number loop's rounding matters most
+constexpr unsigned long int fuzz_short_steps = 1024;
+
 /// <summary>
-/// Template function to abstract away the logic of:
-///   start - (increment * steps)
+/// What one shard of the fuzz checked, and how many of those checks failed
 /// </summary>
-/// <typeparam name="T">A type that with basic math functions</typeparam>
-/// <param name="start">The number to start with</param>
-/// <param name="increment">How much to subtract each step</param>
-/// <param name="steps">The number of steps to iterate</param>
-/// <returns>start - (increment * steps)</returns>
+struct fuzz_tally
+{
+    unsigned long long cases = 0;
+    unsigned long long mismatches = 0;
+};
 
+/// <summary>
+/// The values most likely to break the arithmetic: zero, one, the limits and their neighbours, and for real numbers
+/// the smallest normal and denormal values, infinities and NaN
+/// </summary>
 template <typename T>
-T subtract_numbers(T const& start, T const& decrement, unsigned long int const& steps)
+std::vector<T> fuzz_edge_values()
 {
-    T result = start;
-
-    for (unsigned long int i = 0; i < steps; ++i)
-    {
-        // Check for underflow for signed types before subtracting next decrement
-        // Logic is: if the result is less than the lowest value plus the decrement, then one more decrement will underflow
-        if ((std::is_signed<T>::value) && (result < std::numeric_limits<T>::lowest() + decrement)) {
-            std::cout << "Underflow detected! Cannot subtract " << +decrement << " from " << +result << ", please consider using a different data type." << std::endl;
+    using limits = std::numeric_limits<T>;
+    std::vector<T> values = {
+        T(0), T(1), T(2), T(3),
+        limits::max(), static_cast<T>(limits::max() - 1), static_cast<T>(limits::max() / 2), static_cast<T>(limits::max() / 2 + 1),
+        limits::lowest(), static_cast<T>(limits::lowest() + 1), static_cast<T>(limits::lowest() / 2)
+    };
 
-            return std::numeric_limits<T>::lowest();  // Break the loop
+    if constexpr (is_signed_type<T>) {
+        for (const T value : { static_cast<T>(-1), static_cast<T>(-2) }) {
+            values.push_back(value);
         }
-        // Otherwise, check for underflow for unsigned types
-        // Logic is: unsigned types' lowest value is 0, so if result is less than the decrement, another decrement would make result negative
-        else if (result < decrement) {
-            std::cout << "Underflow detected! Cannot subtract " << +decrement << " from " << +result << ", please consider using a different data type." << std::endl;
+    }
+    if constexpr (!is_integer_type<T>) {
+        for (const T value : { limits::denorm_min(), -limits::denorm_min(), limits::min(), -limits::min(), limits::epsilon(),
+            static_cast<T>(-0.0), static_cast<T>(0.5), limits::infinity(), -limits::infinity(), limits::quiet_NaN() }) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
 
-            return std::numeric_limits<T>::lowest();  // Break the loop
+/// <summary>
+/// A value for the fuzz: an edge value, a small number, a neighbour of an edge value or any value at all of T
+/// </summary>
+template <typename T>
+T fuzz_value(std::mt19937_64& random, const std::vector<T>& edges)
+{
+    switch (random() % 4)
+    {
+    case 0:
+        return edges[random() % edges.size()];
+    case 1:
+        return is_signed_type<T> && (random() & 1) ? static_cast<T>(-static_cast<int>(random() % 16)) : static_cast<T>(random() % 16);
+    case 2:
+        if constexpr (is_integer_type<T>) {
+            // in unsigned arithmetic, which wraps around the limits instead of overflowing
+            using U = typename unsigned_of<T>::type;
+            return static_cast<T>(static_cast<U>(static_cast<U>(edges[random() % edges.size()]) + static_cast<U>(random() % 5) - U(2)));
         }
-        // If no underflow is detected, subtraction can continue safely
         else {
-            result -= decrement;
+            // a few units in the last place either side of the edge value
+            T value = edges[random() % edges.size()];
+            for (unsigned long long nudges = random() % 3; nudges > 0; --nudges) {
+                value = std::nextafter(value, (random() & 1) ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity());
+            }
+            return value;
+        }
+    default:
+        if constexpr (!is_integer_type<T> && sizeof(T) > sizeof(std::uint64_t)) {
+            // not every bit pattern of a long double is a number, so build one from a random sign, mantissa and exponent
+            // (anything from the denormals up to max)
+            using limits = std::numeric_limits<T>;
+            const int exponent = limits::min_exponent - limits::digits + static_cast<int>(random() % (limits::max_exponent - limits::min_exponent + limits::digits));
+            const T value = std::ldexp(static_cast<T>(random() >> 11) / static_cast<T>(1ull << 53), exponent);
+            return (random() & 1) ? -value : value;
+        }
+        else {
+            // any bit pattern at all, which for float and double includes the denormals, infinities and NaNs
+            T value{};
+            for (std::size_t filled = 0; filled < sizeof(T); filled += sizeof(std::uint64_t)) {
+                const std::uint64_t bits = random();
+                std::memcpy(reinterpret_cast<unsigned char*>(&value) + filled, &bits, std::min(sizeof(T) - filled, sizeof(bits)));
+            }
+            return value;
         }
     }
+}
 
-    // Return the result after decrementing is complete, i.e. no underflow occurred
-    return result;
+/// <summary>
+/// A step count for the fuzz, favouring the counts that land right at the limit and the switch in checked_add_real /
+/// checked_subtract_real from replaying the real number loop to working it out
+/// </summary>
+template <typename T>
+unsigned long int fuzz_steps(std::mt19937_64& random, T const& start, T const& step_size)
+{
+    switch (random() % 6)
+    {
+    case 0:
+        return static_cast<unsigned long int>(random() % 4);
+    case 1:
+        return static_cast<unsigned long int>(real_number_replay_steps - 2 + random() % 5);
+    case 2:
+        return static_cast<unsigned long int>(random() % fuzz_short_steps);
+    case 3:
+        return (random() & 1) ? std::numeric_limits<unsigned long int>::max() : static_cast<unsigned long int>(random());
+    default:
+        // just short of, at, or just past the limit in whichever direction the step takes the value
+        if constexpr (is_integer_type<T>) {
+            using U = typename unsigned_of<T>::type;
+            const bool going_down = is_negative(step_size);
+            const U room = going_down
+                ? static_cast<U>(static_cast<U>(start) - static_cast<U>(std::numeric_limits<T>::lowest()))
+                : static_cast<U>(static_cast<U>(std::numeric_limits<T>::max()) - static_cast<U>(start));
+            const U magnitude = going_down ? static_cast<U>(U(0) - static_cast<U>(step_size)) : static_cast<U>(step_size);
+            const unsigned long long fitting = steps_that_fit(room, magnitude, std::numeric_limits<unsigned long int>::max());
+            return static_cast<unsigned long int>(fitting + random() % 3 - 1);
+        }
+        else {
+            const long double room = static_cast<long double>(std::numeric_limits<T>::max()) - static_cast<long double>(start < 0 ? -start : start);
+            const long double magnitude = static_cast<long double>(step_size < 0 ? -step_size : step_size);
+            const long double fitting = room / magnitude;
+            if (!(fitting >= 0 && fitting < static_cast<long double>(fuzz_short_steps))) {
+                return static_cast<unsigned long int>(random() % fuzz_short_steps);
+            }
+            return static_cast<unsigned long int>(fitting) + static_cast<unsigned long int>(random() % 3);
+        }
+    }
 }
 
+/// <summary>
+/// Going from start by steps of magnitude (down towards lowest, or up towards max) for integers, worked out in a type
+/// wide enough that it cannot overflow
+/// </summary>
+template <typename T>
+checked_result<T> fuzz_expected_steps(T const& start, bool going_down, fuzz_wide_unsigned magnitude, unsigned long int steps)
+{
+    const fuzz_wide_int from = static_cast<fuzz_wide_int>(start);
+    const fuzz_wide_unsigned room = static_cast<fuzz_wide_unsigned>(going_down
+        ? from - static_cast<fuzz_wide_int>(std::numeric_limits<T>::lowest())
+        : static_cast<fuzz_wide_int>(std::numeric_limits<T>::max()) - from);
+
+    const fuzz_wide_unsigned total = magnitude * steps;
+    if (total <= room) {
+        const T value = static_cast<T>(going_down ? from - static_cast<fuzz_wide_int>(total) : from + static_cast<fuzz_wide_int>(total));
+        return { value, overflow_status::none, value, 0 };
+    }
 
-//  NOTE:
-//    You will see the unary ('+') operator used in front of the variables in the test_XXX methods.
-//    This forces the output to be a number for cases where cout would assume it is a character. 
+    const fuzz_wide_unsigned completed = room / magnitude;
+    const fuzz_wide_int distance = static_cast<fuzz_wide_int>(completed * magnitude);
+    const T reached = static_cast<T>(going_down ? from - distance : from + distance);
+    if (going_down) {
+        return { std::numeric_limits<T>::lowest(), overflow_status::underflow, reached, static_cast<unsigned long long>(completed) };
+    }
+    return { std::numeric_limits<T>::max(), overflow_status::overflow, reached, static_cast<unsigned long long>(completed) };
+}
 
+/// <summary>
+/// start + (increment * steps) for integers, a negative increment heading for the lowest value
+/// </summary>
 template <typename T>
-void test_overflow()
+checked_result<T> fuzz_expected_add(T const& start, T const& increment, unsigned long int steps)
 {
-    // START DO NOT CHANGE
-    //  how many times will we iterate
-    const unsigned long int steps = 5;
-    // how much will we add each step (result should be: start + (increment * steps))
-    const T increment = std::numeric_limits<T>::max() / steps;
-    // whats our starting point
-    const T start = 0;
+    const fuzz_wide_int wide_increment = static_cast<fuzz_wide_int>(increment);
+    return fuzz_expected_steps(start, wide_increment < 0, static_cast<fuzz_wide_unsigned>(wide_increment < 0 ? -wide_increment : wide_increment), steps);
+}
 
-    std::cout << "Overflow Test of Type = " << typeid(T).name() << std::endl;
-    // END DO NOT CHANGE
+/// <summary>
+/// start - (decrement * steps) for integers. As with the loop going below zero is an underflow,
+/// and a negative decrement heads up towards max.
+/// </summary>
+template <typename T>
+checked_result<T> fuzz_expected_subtract(T const& start, T const& decrement, unsigned long int steps)
+{
+    const fuzz_wide_int wide_decrement = static_cast<fuzz_wide_int>(decrement);
+    if (wide_decrement < 0) {
+        return fuzz_expected_steps(start, false, static_cast<fuzz_wide_unsigned>(-wide_decrement), steps);
+    }
 
-    std::cout << "\tAdding Numbers Without Overflow (" << +start << ", " << +increment << ", " << steps << ") = ";
-    T result = add_numbers<T>(start, increment, steps);
-    std::cout << +result << std::endl;
+    const fuzz_wide_int from = static_cast<fuzz_wide_int>(start);
+    const fuzz_wide_unsigned total = static_cast<fuzz_wide_unsigned>(wide_decrement) * steps;
+    if (steps == 0 || (from >= 0 && total <= static_cast<fuzz_wide_unsigned>(from))) {
+        const T value = static_cast<T>(from - static_cast<fuzz_wide_int>(total));
+        return { value, overflow_status::none, value, 0 };
+    }
 
-    std::cout << "\tAdding Numbers With Overflow (" << +start << ", " << +increment << ", " << (steps + 1) << ") = ";
-    result = add_numbers<T>(start, increment, steps + 1);
+    // a start already below zero underflows on the first step
+    const fuzz_wide_int completed = from < 0 ? 0 : from / wide_decrement;
+    const T reached = static_cast<T>(from - completed * wide_decrement);
+    return { std::numeric_limits<T>::lowest(), overflow_status::underflow, reached, static_cast<unsigned long long>(completed) };
+}
 
-    // Check whether overflow occurred
-    // If result is returned as the max value, this means overflow was caught in add_numbers()
-    if (result == std::numeric_limits<T>::max()) {
-        return;
+/// <summary>
+/// The outcome of a real number run, worked out in long double from the first step whose value is past the threshold
+/// the loop checks before each step, rather than by stepping as add_numbers / subtract_numbers do
+/// </summary>
+template <typename T>
+checked_result<T> fuzz_expected_real(T const& start, T const& step_size, unsigned long int steps, bool subtract)
+{
+    using limits = std::numeric_limits<T>;
+
+    // NaN never compares as past a threshold, so the loop runs it to the end
+    if (steps == 0 || start != start || step_size != step_size) {
+        const T value = steps == 0 ? start : limits::quiet_NaN();
+        return { value, overflow_status::none, value, 0 };
+    }
+
+    // the thresholds are worked out in T, as the loop does, and a positive decrement heads for zero
+    const bool going_down = subtract ? !(step_size < 0) : step_size < 0;
+    const long double threshold = static_cast<long double>(subtract
+        ? (going_down ? step_size : static_cast<T>(limits::max() + step_size))
+        : (going_down ? static_cast<T>(limits::lowest() - step_size) : static_cast<T>(limits::max() - step_size)));
+    const long double from = static_cast<long double>(start);
+    const long double move = subtract ? -static_cast<long double>(step_size) : static_cast<long double>(step_size);
+
+    long double past_at = 0.0L;
+    if (going_down ? from < threshold : from > threshold) {
+        past_at = 0;
+    }
+    else if (move == 0) {
+        past_at = static_cast<long double>(steps);
     }
     else {
-        std::cout << +result << std::endl;
+        past_at = std::floor((threshold - from) / move) + 1;
+    }
+
+    if (!(past_at < static_cast<long double>(steps))) {
+        // an infinite start stays where it is whatever the steps add up to, unless a step is the opposite infinity
+        const bool cancels = std::isinf(move) && (move < 0) != (from < 0);
+        const T value = std::isinf(from) ? (cancels ? limits::quiet_NaN() : start) : static_cast<T>(from + move * static_cast<long double>(steps));
+        return { value, overflow_status::none, value, 0 };
     }
+
+    // (an infinite step size never moves the value, rather than making 0 * infinity of it)
+    const long double completed = std::max(0.0L, past_at);
+    const T reached = completed == 0 ? start : static_cast<T>(from + move * completed);
+    if (going_down) {
+        return { limits::lowest(), overflow_status::underflow, reached, static_cast<unsigned long long>(completed) };
+    }
+    return { limits::max(), overflow_status::overflow, reached, static_cast<unsigned long long>(completed) };
 }
 
+/// <summary>
+/// Whether two values of T are the same, NaN being the same as NaN
+/// </summary>
 template <typename T>
-void test_underflow()
+bool fuzz_same_value(T const& left, T const& right)
 {
-    // START DO NOT CHANGE
-    //  how many times will we iterate
-    const unsigned long int steps = 5;
-    // how much will we subtract each step (result should be: start - (increment * steps))
-    const T decrement = std::numeric_limits<T>::max() / steps;
-    // whats our starting point
-    const T start = std::numeric_limits<T>::max();
+    if constexpr (!is_integer_type<T>) {
+        if (left != left) {
+            return right != right;
+        }
+    }
+    return left == right;
+}
 
-    std::cout << "Underflow Test of Type = " << typeid(T).name() << std::endl;
-    // END DO NOT CHANGE
+/// <summary>
+/// Whether a checked_result is exactly the expected one
+/// </summary>
+template <typename T>
+bool fuzz_matches(checked_result<T> const& actual, checked_result<T> const& expected)
+{
+    return actual.status == expected.status && actual.step == expected.step
+        && fuzz_same_value(actual.value, expected.value) && fuzz_same_value(actual.reached, expected.reached);
+}
 
-    std::cout << "\tSubtracting Numbers Without Underflow (" << +start << ", " << +decrement << ", " << steps << ") = ";
-    auto result = subtract_numbers<T>(start, decrement, steps);
-    std::cout << +result << std::endl;
+/// <summary>
+/// Whether a real number result is the expected one give or take rounding_steps roundings of the largest value the
+/// run passes through. Logic is:
+///   with the same outcome, the values may be that far apart and the step one either side
+///   with a different outcome, the run that stayed in range must have ended within that rounding of the limit
+/// </summary>
+template <typename T>
+bool fuzz_close_enough(checked_result<T> const& actual, checked_result<T> const& expected, T const& start, T const& step_size,
+    unsigned long int steps, bool subtract, long double rounding_steps)
+{
+    if (fuzz_matches(actual, expected)) {
+        return true;
+    }
 
-    std::cout << "\tSubtracting Numbers With Underflow (" << +start << ", " << +decrement << ", " << (steps + 1) << ") = ";
-    result = subtract_numbers<T>(start, decrement, steps + 1);
+    using limits = std::numeric_limits<T>;
+    const long double size = std::fabs(static_cast<long double>(step_size));
+    const long double tolerance = (std::fabs(static_cast<long double>(start)) + size * static_cast<long double>(steps))
+        * static_cast<long double>(limits::epsilon()) * rounding_steps + static_cast<long double>(limits::denorm_min());
 
-    // Check whether underflow occurred
-    // If result is returned as the lowest value, this means underflow was caught in add_numbers()
-    if (result == std::numeric_limits<T>::lowest()) {
-        return;
+    // values past the limits (the infinities) are as far out of range as the limits themselves
+    const auto in_range = [](T const& value) {
+        return std::max(static_cast<long double>(limits::lowest()), std::min(static_cast<long double>(value), static_cast<long double>(limits::max())));
+    };
+    const auto near = [&](T const& left, T const& right, long double allowed) {
+        if (left != left || right != right) {
+            return left != left && right != right;
+        }
+        return !(std::fabs(in_range(left) - in_range(right)) > allowed);
+    };
+
+    if (actual.status == expected.status) {
+        const unsigned long long step_apart = actual.step > expected.step ? actual.step - expected.step : expected.step - actual.step;
+        return near(actual.value, expected.value, tolerance) && near(actual.reached, expected.reached, tolerance + size)
+            && (step_apart <= 1 || static_cast<long double>(step_apart) * size <= tolerance);
     }
-    else {
-        std::cout << +result << std::endl;
+
+    const checked_result<T>& stopped = actual.status == overflow_status::none ? expected : actual;
+    const checked_result<T>& finished = actual.status == overflow_status::none ? actual : expected;
+    if (finished.status != overflow_status::none) {
+        return false;
     }
+
+    // below zero is the limit for a positive decrement
+    const long double limit = stopped.status == overflow_status::overflow
+        ? static_cast<long double>(limits::max())
+        : (subtract ? 0.0L : static_cast<long double>(limits::lowest()));
+    return !(std::fabs(in_range(finished.value) - limit) > tolerance + size);
 }
 
-void do_overflow_tests(const std::string& star_line)
+/// <summary>
+/// Call add_numbers / subtract_numbers and read back what they returned and reported, as a checked_result.
+/// Logic is:
+///   the value is what the call returned
+///   an overflow it reported gives the status, step and value reached, and must be about this call
+///   no report at all means the call stayed in range
+/// </summary>
+/// <returns>false if the call reported more than once or about anything else</returns>
+template <typename T>
+bool fuzz_call(checked_result<T>& actual, T const& start, T const& step_size, unsigned long int steps, bool subtract)
 {
-    std::cout << std::endl << star_line << std::endl;
-    std::cout << "*** Running Overflow Tests ***" << std::endl;
-    std::cout << star_line << std::endl;
+    const T value = subtract ? subtract_numbers(start, step_size, steps) : add_numbers(start, step_size, steps);
+    actual = { value, overflow_status::none, value, 0 };
 
-    // Testing C++ primative times see: https://www.geeksforgeeks.org/c-data-types/
-    // signed integers
-    test_overflow<char>();
-    test_overflow<wchar_t>();
-    test_overflow<short int>();
-    test_overflow<int>();
-    test_overflow<long>();
-    test_overflow<long long>();
+    bool reported_right = true;
+    const std::size_t reports = drain_this_thread_overflow_events([&](const overflow_event& event) {
+        if (*event.type != typeid(T)) {
+            reported_right = false;
+            return;
+        }
+        reported_right = reported_right && event.steps == steps
+            && event.operation == (subtract ? checked_operation::subtract : checked_operation::add)
+            && fuzz_same_value(event.operand<T>(overflow_event::start_operand), start)
+            && fuzz_same_value(event.operand<T>(overflow_event::step_size_operand), step_size);
+        actual.status = event.status;
+        actual.step = event.step;
+        actual.reached = event.operand<T>(overflow_event::reached_operand);
+    });
 
-    // unsigned integers
-    test_overflow<unsigned char>();
-    test_overflow<unsigned short int>();
-    test_overflow<unsigned int>();
-    test_overflow<unsigned long>();
-    test_overflow<unsigned long long>();
+    return reports <= 1 && reported_right;
+}
 
-    // real numbers
-    test_overflow<float>();
-    test_overflow<double>();
-    test_overflow<long double>();
+/// <summary>
+/// Write one checked_result for a mismatch report
+/// </summary>
+template <typename T>
+void write_fuzz_result(std::ostream& output, checked_result<T> const& result)
+{
+    write_number(output, result.value);
+    if (result.status != overflow_status::none) {
+        output << (result.status == overflow_status::overflow ? " (overflow" : " (underflow") << " at step " << result.step << " from ";
+        write_number(output, result.reached);
+        output << ")";
+    }
 }
 
-void do_underflow_tests(const std::string& star_line)
+/// <summary>
+/// Check cases random add_numbers / subtract_numbers calls, and the overflows they report, against sums worked out
+/// independently for T. Integers must match the wide integer sums exactly; real numbers must match the long double
+/// working within the rounding of the loop (one rounding a step while checked_add_real / checked_subtract_real replay
+/// it, a few once they work it out).
+/// </summary>
+template <typename T>
+fuzz_tally fuzz_arithmetic(std::ostream& output, std::uint64_t seed, std::size_t cases)
+{
+    std::mt19937_64 random(seed);
+    const std::vector<T> edges = fuzz_edge_values<T>();
+
+    fuzz_tally tally;
+    for (std::size_t i = 0; i < cases; ++i)
+    {
+        const T start = fuzz_value(random, edges);
+        const T step_size = fuzz_value(random, edges);
+        const unsigned long int steps = fuzz_steps(random, start, step_size);
+        const bool subtract = (random() & 1) != 0;
+
+        checked_result<T> actual{};
+        bool matched = fuzz_call(actual, start, step_size, steps, subtract);
+
+        checked_result<T> expected{};
+        if constexpr (is_integer_type<T>) {
+            expected = subtract ? fuzz_expected_subtract(start, step_size, steps) : fuzz_expected_add(start, step_size, steps);
+            matched = matched && fuzz_matches(actual, expected);
+        }
+        else {
+            const long double rounding_steps = steps <= real_number_replay_steps ? static_cast<long double>(steps) + 1 : 4.0L;
+            expected = fuzz_expected_real(start, step_size, steps, subtract);
+            matched = matched && fuzz_close_enough(actual, expected, start, step_size, steps, subtract, rounding_steps);
+        }
+
+        ++tally.cases;
+        if (!matched && tally.mismatches++ < fuzz_reported_mismatches) {
+            output << "\tMismatch: " << (subtract ? "subtract_numbers(" : "add_numbers(");
+            write_number(output, start);
+            output << ", ";
+            write_number(output, step_size);
+            output << ", " << steps << ") = ";
+            write_fuzz_result(output, actual);
+            output << ", expected ";
+            write_fuzz_result(output, expected);
+            output << '\n';
+        }
+    }
+
+    return tally;
+}
+
+/// <summary>
+/// The fuzz tests of one type: their name, and which of the sweep's tests are its shards
+/// </summary>
+struct fuzz_type
+{
+    std::string name;
+    std::size_t first_test;
+    std::size_t shards;
+};
+
+/// <summary>
+/// Split cases fuzz cases of each type in Types into shards for run_sweep, each seeded from seed and where it falls
+/// in the run, so a run can be repeated exactly whatever the thread count
+/// </summary>
+template <typename... Types>
+void add_fuzz_tests(std::vector<sweep_test>& tests, std::vector<fuzz_type>& types, std::vector<fuzz_tally>& tallies, std::size_t cases, std::uint64_t seed)
+{
+    const auto add = [&](auto type_tag) {
+        using T = typename decltype(type_tag)::type;
+        const std::size_t shards = std::max<std::size_t>(1, (cases + fuzz_shard_cases - 1) / fuzz_shard_cases);
+        types.push_back({ typeid(T).name(), tests.size(), shards });
+
+        for (std::size_t shard = 0; shard < shards; ++shard)
+        {
+            const std::size_t index = tests.size();
+            const std::size_t shard_cases = std::min(fuzz_shard_cases, cases - std::min(cases, shard * fuzz_shard_cases));
+            const std::uint64_t shard_seed = seed + 0x9E3779B97F4A7C15ull * (index + 1);
+            tests.push_back({ typeid(T).name(), [&tallies, index, shard_seed, shard_cases](std::ostream& output) {
+                tallies[index] = fuzz_arithmetic<T>(output, shard_seed, shard_cases);
+            } });
+        }
+    };
+    (add(std::type_identity<Types>{}), ...);
+    tallies.resize(tests.size());
+}
+
+/// <summary>
+/// Fuzz add_numbers / subtract_numbers with cases random (start, step size, steps) per type on thread_count threads,
+/// reporting each type's mismatches and how many cases a second were checked
+/// </summary>
+/// <returns>the number of mismatches</returns>
+unsigned long long do_fuzz_tests(const std::string& star_line, std::size_t cases, unsigned thread_count, std::uint64_t seed)
 {
+    std::vector<sweep_test> tests;
+    std::vector<fuzz_type> types;
+    std::vector<fuzz_tally> tallies;
+    add_fuzz_tests<char, wchar_t, short int, int, long, long long,
+        unsigned char, unsigned short int, unsigned int, unsigned long, unsigned long long,
+        float, double, long double,
+        std::int8_t>(tests, types, tallies, cases, seed);
+
     std::cout << std::endl << star_line << std::endl;
-    std::cout << "*** Running Underflow Tests ***" << std::endl;
+    std::cout << "*** Fuzzing Overflow Checks (" << cases << " cases per type, " << thread_count << " threads, seed " << seed << ") ***" << std::endl;
     std::cout << star_line << std::endl;
 
-    // Testing C++ primative times see: https://www.geeksforgeeks.org/c-data-types/
-    // signed integers
-    test_underflow<char>();
-    test_underflow<wchar_t>();
-    test_underflow<short int>();
-    test_underflow<int>();
-    test_underflow<long>();
-    test_underflow<long long>();
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<sweep_result> results = run_sweep(tests, thread_count);
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
 
-    // unsigned integers
-    test_underflow<unsigned char>();
-    test_underflow<unsigned short int>();
-    test_underflow<unsigned int>();
-    test_underflow<unsigned long>();
-    test_underflow<unsigned long long>();
+    fuzz_tally total;
+    for (const fuzz_type& type : types)
+    {
+        fuzz_tally tally;
+        std::chrono::duration<double> busy{};
+        std::string mismatches;
+        for (std::size_t test = type.first_test; test < type.first_test + type.shards; ++test)
+        {
+            tally.cases += tallies[test].cases;
+            tally.mismatches += tallies[test].mismatches;
+            busy += results[test].elapsed;
+            mismatches += results[test].output;
+        }
+        total.cases += tally.cases;
+        total.mismatches += tally.mismatches;
 
-    // real numbers
-    test_underflow<float>();
-    test_underflow<double>();
-    test_underflow<long double>();
+        std::cout << "Fuzz Test of Type = " << type.name << ": " << tally.cases << " cases, " << tally.mismatches << " mismatches, "
+            << std::fixed << std::setprecision(0) << tally.cases / busy.count() << " cases/s per thread" << std::endl;
+        std::cout << mismatches;
+    }
+
+    std::cout << std::endl << total.cases << " cases, " << total.mismatches << " mismatches in " << std::setprecision(3) << wall.count()
+        << " s (" << std::setprecision(0) << total.cases / wall.count() << " cases/s)" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+
+    return total.mismatches;
+}
+
+/// <summary>
+/// Whether text is a whole number, nothing before or after it, that fits in T: a count given on the command line
+/// </summary>
+template <typename T>
+bool parse_count(std::string_view text, T& count)
+{
+    const auto parsed = std::from_chars(text.data(), text.data() + text.length(), count);
+    return parsed.ec == std::errc() && parsed.ptr == text.data() + text.length();
 }
 
 /// <summary>
 /// Entry point into the application
 /// </summary>
+/// <param name="argc">--sweep [steps] [threads] runs the concurrent type sweep instead of the standard tests,
+/// --fuzz [cases] [threads] [seed] fuzzes the overflow checks</param>
 /// <returns>0 when complete</returns>
-int main()
+int main(int argc, char* argv[])
 {
     //  create a string of "*" to use in the console
     const std::string star_line = std::string(50, '*');
 
+    if (argc > 1 && std::string(argv[1]) == "--sweep")
+    {
+        unsigned long int steps = 5;
+        unsigned threads = std::thread::hardware_concurrency();
+        if ((argc > 2 && !parse_count(argv[2], steps)) || (argc > 3 && !parse_count(argv[3], threads))) {
+            std::cout << "Usage: --sweep [steps] [threads], where steps and threads are whole numbers" << std::endl;
+            return -1;
+        }
+        do_type_sweep(star_line, std::max(1ul, steps), std::max(1u, threads));
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--fuzz")
+    {
+        std::size_t cases = 1000000;
+        unsigned threads = std::thread::hardware_concurrency();
+        std::uint64_t seed = 405;
+        if ((argc > 2 && (!parse_count(argv[2], cases) || cases == 0)) || (argc > 3 && !parse_count(argv[3], threads))
+            || (argc > 4 && !parse_count(argv[4], seed))) {
+            std::cout << "Usage: --fuzz [cases] [threads] [seed], where cases (at least 1), threads and seed are whole numbers" << std::endl;
+            return -1;
+        }
+        return do_fuzz_tests(star_line, cases, std::max(1u, threads), seed) == 0 ? 0 : -1;
+    }
+
     std::cout << "Starting Numeric Underflow / Overflow Tests!" << std::endl;
 
     // run the overflow tests
@@ -2,11 +2,26 @@
 //
 
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <list>
 #include <locale>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
 #include <tuple>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
-#include <regex>
 
 #include "sqlite3.h"
 // DO NOT CHANGE
@@ -73,28 +88,450 @@ bool initialize_database(sqlite3* db)
     return true;
 }
 
+/// <summary>
+/// secondary indexes on the columns USERS is looked up by, beyond the ID its primary key already indexes, so a lookup
+/// such as NAME='Fred' searches an index in time growing with the log of the table's size instead of scanning every
+/// row. SQLite updates an index with every write to its table, so creating them once is all the upkeep they need,
+/// though on a table about to be bulk loaded it is quicker to create them after the load than to update them through it.
+/// </summary>
+bool create_lookup_indexes(sqlite3* db)
+{
+    static const char* const indexes[] = {
+        "CREATE INDEX IF NOT EXISTS USERS_NAME ON USERS(NAME);",
+    };
+
+    for (const char* sql : indexes)
+    {
+        char* error_message = NULL;
+        if (sqlite3_exec(db, sql, NULL, NULL, &error_message) != SQLITE_OK)
+        {
+            std::cout << "Failed to index USERS table. ERROR = " << error_message << std::endl;
+            sqlite3_free(error_message);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// <summary>
+/// a query character as the tautology screen compares it: ASCII letters lowercased, everything else as it is
+/// </summary>
+static inline unsigned char screen_lower(char c)
+{
+    const unsigned char u = static_cast<unsigned char>(c);
+    return u >= 'A' && u <= 'Z' ? static_cast<unsigned char>(u - 'A' + 'a') : u;
+}
+
+// characters a tautology's operands are made of (once lowercased): letters, digits and quotes
+static inline bool is_operand_character(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '\'';
+}
+
+// what a regex \w matches
+static inline bool is_word_character(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// what a regex \s matches
+static inline bool is_space_character(unsigned char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// whether a regex \b matches before sql[position]
+static inline bool is_word_boundary(std::string_view sql, size_t position)
+{
+    const bool word_before = position > 0 && is_word_character(static_cast<unsigned char>(sql[position - 1]));
+    const bool word_after = position < sql.length() && is_word_character(static_cast<unsigned char>(sql[position]));
+    return word_before != word_after;
+}
+
+/// <summary>
+/// whether sql sets something equal to itself (1=1, 'hi' = 'HI', ...), the tell-tale of an injected tautology.
+/// finds exactly what the pattern \b([a-z0-9']+)\s*=\s*\1\b found in a lowercased copy of the query, without the copy
+/// and in time linear in the query's length (the regex was rebuilt on every call, and backtracked).
+/// Logic is:
+///   the operand before the = can only end where its run of operand characters does, so each run is tried once,
+///   as the text on the left of "run = rest". the operands that match are the run's suffixes that are also prefixes
+///   of rest; matching rest against the run (KMP) finds the longest, its borders give the shorter ones, and each
+///   is then checked for word boundaries at both ends as \b would.
+/// </summary>
+bool contains_tautology(std::string_view sql)
+{
+    // KMP failure function of the right hand operand, kept between calls so screening does not allocate
+    thread_local std::vector< size_t > failure;
+
+    const size_t length = sql.length();
+    size_t run_start = 0;
+    while (run_start < length)
+    {
+        // the next run of operand characters
+        while (run_start < length && !is_operand_character(screen_lower(sql[run_start]))) ++run_start;
+        size_t run_end = run_start;
+        while (run_end < length && is_operand_character(screen_lower(sql[run_end]))) ++run_end;
+        if (run_start == run_end) break;
+
+        // followed by = (with any spacing), and then whatever might repeat it
+        size_t right = run_end;
+        while (right < length && is_space_character(static_cast<unsigned char>(sql[right]))) ++right;
+        if (right == length || sql[right] != '=')
+        {
+            run_start = run_end;
+            continue;
+        }
+        ++right;
+        while (right < length && is_space_character(static_cast<unsigned char>(sql[right]))) ++right;
+
+        // the right hand operand can be no longer than the run on the left
+        size_t right_length = 0;
+        while (right_length < run_end - run_start && right + right_length < length
+            && is_operand_character(screen_lower(sql[right + right_length]))) ++right_length;
+
+        if (right_length > 0)
+        {
+            failure.resize(right_length);
+            failure[0] = 0;
+            for (size_t i = 1, k = 0; i < right_length; ++i)
+            {
+                while (k > 0 && screen_lower(sql[right + i]) != screen_lower(sql[right + k])) k = failure[k - 1];
+                if (screen_lower(sql[right + i]) == screen_lower(sql[right + k])) ++k;
+                failure[i] = k;
+            }
+
+            // the longest suffix of the run that starts the right hand side
+            size_t matched = 0;
+            for (size_t i = run_start; i < run_end; ++i)
+            {
+                while (matched > 0 && (matched == right_length || screen_lower(sql[i]) != screen_lower(sql[right + matched]))) matched = failure[matched - 1];
+                if (screen_lower(sql[i]) == screen_lower(sql[right + matched])) ++matched;
+            }
+
+            for (; matched > 0; matched = failure[matched - 1])
+            {
+                if (is_word_boundary(sql, run_end - matched) && is_word_boundary(sql, right + matched))
+                {
+                    return true;
+                }
+            }
+        }
+
+        run_start = run_end;
+    }
+
+    return false;
+}
+
+/// <summary>
+/// screens SQL for injection as it arrives, in chunks of any size (a file read a block at a time, a socket, ...), in
+/// one pass over it and in fixed memory, however big it is. unlike contains_tautology it tokenizes the SQL as SQLite
+/// would, so:
+/// - text inside a string literal or a comment is never mistaken for SQL (NAME='a=a' is a name)
+/// - a literal is one operand, so 'hi'='hi' compares whole literals
+/// - comments count as white space (1/**/=/**/1 is still caught)
+/// and it counts statements, so a statement stacked after another by an injected ; is flagged too.
+/// Logic is:
+/// 1) each character moves a state machine through code, words, quoted text and comments. the states remember a
+///    character that needs the next to decide on (-, /, a closing quote), so a chunk can end anywhere.
+/// 2) each operand's text is kept as a digest (length, hash and first characters, lowercased) rather than in full
+/// 3) an operand, =, then an operand with the same digest is a tautology
+/// 4) a ; ends a statement, and anything other than white space or comments after it starts another
+/// </summary>
+class injection_screener
+{
+public:
+    /// <summary>
+    /// screen the next chunk of SQL
+    /// </summary>
+    void feed(std::string_view chunk)
+    {
+        for (const char c : chunk)
+        {
+            step(static_cast<unsigned char>(c));
+            ++offset;
+        }
+    }
+
+    /// <summary>
+    /// the SQL has all been fed: end whatever word or literal it ended in
+    /// </summary>
+    void finish()
+    {
+        step(' ');
+    }
+
+    /// <summary>
+    /// start again on new SQL
+    /// </summary>
+    void reset()
+    {
+        *this = injection_screener();
+    }
+
+    size_t tautologies() const { return tautology_count; }
+    size_t statements() const { return statement_count; }
+    bool stacked_statements() const { return statement_count > 1; }
+
+    /// <summary>
+    /// whether one query, as run_query is given, looks injected: it has a tautology or more than one statement
+    /// </summary>
+    bool suspicious() const { return tautology_count > 0 || stacked_statements(); }
+
+    /// <summary>
+    /// where in the SQL the first tautology ended, a byte count from its start (meaningless without one)
+    /// </summary>
+    size_t first_tautology_offset() const { return tautology_offset; }
+
+private:
+    enum class lexer_state { code, word, dash, slash, line_comment, block_comment, block_comment_star, quoted, quote_closed };
+    enum class comparison { none, after_operand, after_equals };
+
+    // enough of an operand to tell it from another: equal digests are, all but certainly, equal operands
+    struct operand_digest
+    {
+        static constexpr size_t kept_characters = 32;
+
+        size_t length = 0;
+        uint64_t hash = 14695981039346656037ull;
+        char prefix[kept_characters] = {};
+
+        void add(unsigned char c)
+        {
+            if (length < kept_characters) prefix[length] = static_cast<char>(c);
+            ++length;
+            // FNV-1a
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+
+        bool operator==(const operand_digest& other) const
+        {
+            return length == other.length && hash == other.hash
+                && std::memcmp(prefix, other.prefix, std::min(length, kept_characters)) == 0;
+        }
+    };
+
+    // the characters of a word: names, keywords and numbers, including qualified names and decimals
+    static bool is_token_character(unsigned char c)
+    {
+        return is_word_character(c) || c == '.' || c == '$' || c >= 0x80;
+    }
+
+    void step(unsigned char c)
+    {
+        switch (state)
+        {
+        case lexer_state::word:
+            if (is_token_character(c))
+            {
+                operand.add(screen_lower(static_cast<char>(c)));
+                return;
+            }
+            end_operand();
+            break;
+        case lexer_state::dash:
+            if (c == '-')
+            {
+                state = lexer_state::line_comment;
+                return;
+            }
+            symbol('-');
+            break;
+        case lexer_state::slash:
+            if (c == '*')
+            {
+                state = lexer_state::block_comment;
+                return;
+            }
+            symbol('/');
+            break;
+        case lexer_state::line_comment:
+            if (c == '\n') state = lexer_state::code;
+            return;
+        case lexer_state::block_comment:
+            if (c == '*') state = lexer_state::block_comment_star;
+            return;
+        case lexer_state::block_comment_star:
+            if (c == '/') state = lexer_state::code;
+            else if (c != '*') state = lexer_state::block_comment;
+            return;
+        case lexer_state::quoted:
+            operand.add(screen_lower(static_cast<char>(c)));
+            if (c == closing_quote) state = lexer_state::quote_closed;
+            return;
+        case lexer_state::quote_closed:
+            // a doubled quote is one quote inside the literal ([...] has no escape)
+            if (c == closing_quote && closing_quote != ']')
+            {
+                operand.add(c);
+                state = lexer_state::quoted;
+                return;
+            }
+            end_operand();
+            break;
+        case lexer_state::code:
+            break;
+        }
+
+        // in code, between tokens
+        state = lexer_state::code;
+        if (is_space_character(c))
+        {
+            return;
+        }
+        if (is_token_character(c))
+        {
+            begin_operand(c);
+            state = lexer_state::word;
+        }
+        else if (c == '\'' || c == '"' || c == '`' || c == '[')
+        {
+            begin_operand(c);
+            closing_quote = c == '[' ? ']' : c;
+            state = lexer_state::quoted;
+        }
+        else if (c == '-')
+        {
+            state = lexer_state::dash;
+        }
+        else if (c == '/')
+        {
+            state = lexer_state::slash;
+        }
+        else
+        {
+            symbol(c);
+        }
+    }
+
+    // a word or quoted text, not a comment, white space or ;
+    void significant()
+    {
+        if (!in_statement)
+        {
+            in_statement = true;
+            ++statement_count;
+        }
+    }
+
+    void begin_operand(unsigned char c)
+    {
+        significant();
+        operand = operand_digest();
+        operand.add(screen_lower(static_cast<char>(c)));
+    }
+
+    void end_operand()
+    {
+        if (pending == comparison::after_equals && operand == left_operand)
+        {
+            if (tautology_count++ == 0) tautology_offset = offset;
+        }
+        left_operand = operand;
+        pending = comparison::after_operand;
+    }
+
+    void symbol(unsigned char c)
+    {
+        if (c == ';')
+        {
+            in_statement = false;
+            pending = comparison::none;
+            return;
+        }
+
+        significant();
+        if (c == '=' && pending != comparison::none)
+        {
+            // = or ==
+            pending = comparison::after_equals;
+        }
+        else
+        {
+            pending = comparison::none;
+        }
+    }
+
+    lexer_state state = lexer_state::code;
+    unsigned char closing_quote = '\0';
+    operand_digest operand;
+    operand_digest left_operand;
+    comparison pending = comparison::none;
+    bool in_statement = false;
+    size_t offset = 0;
+    size_t statement_count = 0;
+    size_t tautology_count = 0;
+    size_t tautology_offset = 0;
+};
+
+/// <summary>
+/// when set (--explain), explain_query_plan shows the plan of every query run_query runs and of every statement the
+/// statement cache prepares. set it before any queries run, it is read from every thread.
+/// </summary>
+bool explain_queries = false;
+
+/// <summary>
+/// show how SQLite will run each statement in sql, from EXPLAIN QUERY PLAN, flagging every step that reads a table or
+/// index from end to end rather than searching it: each of those takes time in proportion to the table's size.
+/// </summary>
+/// <returns>how many scans the plans have (a statement that cannot be prepared is left for running it to report)</returns>
+size_t explain_query_plan(sqlite3* db, const std::string& sql)
+{
+    size_t scans = 0;
+    std::cout << "\nQuery plan for: " << sql << std::endl;
+
+    // sql can hold several statements, and EXPLAIN QUERY PLAN takes one at a time
+    const char* next = sql.c_str();
+    while (*next != '\0')
+    {
+        sqlite3_stmt* statement = NULL;
+        if (sqlite3_prepare_v2(db, next, -1, &statement, &next) != SQLITE_OK) break;
+
+        // only white space or a comment was left
+        if (statement == NULL) continue;
+
+        const std::string explain = std::string("EXPLAIN QUERY PLAN ") + sqlite3_sql(statement);
+        sqlite3_finalize(statement);
+
+        sqlite3_stmt* plan = NULL;
+        if (sqlite3_prepare_v2(db, explain.c_str(), -1, &plan, NULL) != SQLITE_OK) break;
+
+        while (sqlite3_step(plan) == SQLITE_ROW)
+        {
+            // the fourth column describes the step: SEARCH USERS USING INDEX ..., SCAN USERS, ...
+            const unsigned char* text = sqlite3_column_text(plan, 3);
+            const std::string_view detail = text == NULL ? std::string_view() : reinterpret_cast<const char*>(text);
+            const bool scan = detail.substr(0, 5) == "SCAN " && detail != "SCAN CONSTANT ROW";
+
+            std::cout << "  " << detail << (scan ? "  <== full scan" : "") << std::endl;
+            if (scan) ++scans;
+        }
+        sqlite3_finalize(plan);
+    }
+
+    return scans;
+}
+
 bool run_query(sqlite3* db, const std::string& sql, std::vector< user_record >& records)
 {
     // clear any prior results
     records.clear();
 
-    // convert the query (stored in localCopy variable) to lowercase for consistent checking
-    // localCopy logic borrowed from run_query_injection()
-    std::string localCopy(sql);
-    std::transform(localCopy.begin(), localCopy.end(), localCopy.begin(), ::tolower);
-
-    // using Regex library, establish the tautology pattern to check for when testing the query
-    // this pattern checks for any 1+ characters, numbers, or apostrophes being set as equal to themselves
-    std::regex pattern(R"(\b([a-z0-9']+)\s*=\s*\1\b)");
-
-    // injection suspected - conditional check for tautology pattern
-    if (std::regex_search(localCopy, pattern))
+    // injection suspected - conditional check for any 1+ characters, numbers, or apostrophes being set as equal
+    // to themselves (case-insensitively)
+    if (contains_tautology(sql))
     {
-        // Return suspicious query as-is (not localCopy) to avoid divulging the use of ::tolower
+        // Return suspicious query as-is, not as the screen compared it
         std::cout << "\nSQL injection suspected! Blocked query: " << sql << std::endl;
         return false;
     }
 
+    if (explain_queries)
+    {
+        explain_query_plan(db, sql);
+    }
+
     char* error_message;
 
     // data retrieval failure - generic error message
@@ -182,46 +619,1581 @@ void run_queries(sqlite3* db)
 
 }
 
-// You can change main by adding stuff to it, but all of the existing code must remain and be
-// in the order called (with none of this existing code placed into conditional statements)
-int main()
+/// <summary>
+/// least recently used cache of prepared statements for one connection, keyed by their SQL text, so a query that is
+/// run again skips SQLite's parser and planner and only has its parameters bound
+/// </summary>
+class statement_cache
 {
-    // initialize random seed:
-    srand(time(nullptr));
+public:
+    statement_cache(sqlite3* db, size_t capacity) : db(db), capacity(capacity)
+    {
+    }
 
-    int return_code = 0;
-    std::cout << "SQL Injection Example" << std::endl;
+    ~statement_cache()
+    {
+        for (const auto& entry : recent)
+        {
+            sqlite3_finalize(entry.statement);
+        }
+    }
 
-    // the database handle
-    sqlite3* db = NULL;
-    char* error_message = NULL;
+    statement_cache(const statement_cache&) = delete;
+    statement_cache& operator=(const statement_cache&) = delete;
 
-    // open the database connection
-    int result = sqlite3_open(":memory:", &db);
+    /// <summary>
+    /// the statement for sql, prepared and cached if it is not already. the statement still belongs to the cache:
+    /// reset it and clear its bindings once finished with it, ready for the next caller.
+    /// </summary>
+    /// <returns>the statement, or NULL if sql is not exactly one statement that prepares (last_error() says why)</returns>
+    sqlite3_stmt* get(const std::string& sql)
+    {
+        const auto found = index.find(sql);
+        if (found != index.end())
+        {
+            // move it to the front, it is now the most recently used
+            recent.splice(recent.begin(), recent, found->second);
+            ++hit_count;
+            return found->second->statement;
+        }
 
-    if (result != SQLITE_OK)
+        ++miss_count;
+
+        if (explain_queries)
+        {
+            explain_query_plan(db, sql);
+        }
+
+        // persistent tells SQLite the statement will be kept and reused, so it is allocated accordingly
+        sqlite3_stmt* statement = NULL;
+        const char* tail = NULL;
+        if (sqlite3_prepare_v3(db, sql.c_str(), static_cast<int>(sql.length() + 1), SQLITE_PREPARE_PERSISTENT, &statement, &tail) != SQLITE_OK)
+        {
+            error = sqlite3_errmsg(db);
+            return NULL;
+        }
+
+        // only the first statement is prepared, so anything stacked after it is refused rather than quietly ignored
+        if (statement == NULL || tail[std::strspn(tail, " \t\r\n;")] != '\0')
+        {
+            sqlite3_finalize(statement);
+            error = "expected exactly one SQL statement";
+            return NULL;
+        }
+
+        recent.push_front({ sql, statement });
+        index.emplace(sql, recent.begin());
+
+        // finalize the least recently used statement
+        if (recent.size() > capacity)
+        {
+            index.erase(recent.back().sql);
+            sqlite3_finalize(recent.back().statement);
+            recent.pop_back();
+        }
+
+        return statement;
+    }
+
+    /// <summary>
+    /// why the last get() returned NULL
+    /// </summary>
+    const std::string& last_error() const { return error; }
+
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+
+private:
+    struct cached_statement
     {
-        std::cout << "Failed to connect to the database and terminating. ERROR=" << sqlite3_errmsg(db) << std::endl;
-        return -1;
+        std::string sql;
+        sqlite3_stmt* statement;
+    };
+
+    sqlite3* const db;
+    const size_t capacity;
+    std::list<cached_statement> recent;
+    std::unordered_map<std::string, std::list<cached_statement>::iterator> index;
+    std::string error;
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+};
+
+/// <summary>
+/// a column of the current row as text, with the same "NULL" callback shows for a missing value
+/// </summary>
+static std::string column_text(sqlite3_stmt* statement, int column)
+{
+    const unsigned char* text = sqlite3_column_text(statement, column);
+    if (text == NULL)
+    {
+        return "NULL";
     }
+    return std::string(reinterpret_cast<const char*>(text), static_cast<size_t>(sqlite3_column_bytes(statement, column)));
+}
 
-    std::cout << "Connected to the database." << std::endl;
+/// <summary>
+/// run a parameterized query, handing visit_row the statement at each row: each ?N placeholder in sql is bound to
+/// parameters[N - 1] as text. the parameters only ever reach SQLite as values, never as SQL, so there is nothing for an
+/// injection to change and no screen is needed. sql itself is the program's own text and comes from the statement
+/// cache after its first run.
+/// </summary>
+template <typename RowVisitor>
+bool step_prepared_query(statement_cache& statements, const std::string& sql, const std::vector< std::string >& parameters, RowVisitor&& visit_row)
+{
+    sqlite3_stmt* statement = statements.get(sql);
+    if (statement == NULL)
+    {
+        std::cout << "Data failed to be queried from USERS table. ERROR = " << statements.last_error() << std::endl;
+        return false;
+    }
 
-    // initialize our database
-    if (!initialize_database(db))
+    if (static_cast<int>(parameters.size()) != sqlite3_bind_parameter_count(statement))
     {
-        std::cout << "Database Initialization Failed. Terminating." << std::endl;
-        return_code = -1;
+        std::cout << "Data failed to be queried from USERS table. ERROR = expected " << sqlite3_bind_parameter_count(statement)
+            << " parameters, got " << parameters.size() << std::endl;
+        return false;
     }
-    else
+
+    // the parameters outlive the statement's use, so SQLite can read them in place instead of copying
+    for (size_t i = 0; i < parameters.size(); ++i)
     {
-        run_queries(db);
+        sqlite3_bind_text(statement, static_cast<int>(i + 1), parameters[i].data(), static_cast<int>(parameters[i].length()), SQLITE_STATIC);
     }
 
-    // close the connection if opened
-    if (db != NULL)
+    int result = sqlite3_step(statement);
+    for (; result == SQLITE_ROW; result = sqlite3_step(statement))
     {
-        sqlite3_close(db);
+        visit_row(statement);
+    }
+
+    if (result != SQLITE_DONE)
+    {
+        std::cout << "Data failed to be queried from USERS table. ERROR = " << sqlite3_errmsg(sqlite3_db_handle(statement)) << std::endl;
+    }
+
+    // hand the statement back to the cache ready for the next caller
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
+
+    return result == SQLITE_DONE;
+}
+
+/// <summary>
+/// run_query for parameterized SQL (see step_prepared_query), collecting the rows as user_records
+/// </summary>
+bool run_prepared_query(statement_cache& statements, const std::string& sql, const std::vector< std::string >& parameters, std::vector< user_record >& records)
+{
+    // clear any prior results
+    records.clear();
+
+    return step_prepared_query(statements, sql, parameters, [&records](sqlite3_stmt* statement)
+    {
+        records.push_back(std::make_tuple(column_text(statement, 0), column_text(statement, 1), column_text(statement, 2)));
+    });
+}
+
+/// <summary>
+/// query results as columns of ID, NAME and PASSWORD, with the text of every value packed into one block and read back
+/// as string_views into it. clear() keeps the memory, so a result set reused across queries stops allocating once it
+/// has held its largest result, where a vector of user_records allocates three strings for every row.
+/// </summary>
+class user_result_set
+{
+public:
+    size_t size() const { return rows; }
+    bool empty() const { return rows == 0; }
+
+    std::string_view id(size_t row) const { return value(id_column, row); }
+    std::string_view name(size_t row) const { return value(name_column, row); }
+    std::string_view password(size_t row) const { return value(password_column, row); }
+
+    /// <summary>
+    /// forget every row, keeping the memory for the next query
+    /// </summary>
+    void clear()
+    {
+        text.clear();
+        for (auto& column : columns)
+        {
+            column.clear();
+        }
+        rows = 0;
+    }
+
+    /// <summary>
+    /// add the row a statement has stepped to, its first three columns being ID, NAME and PASSWORD
+    /// (a missing value is kept as "NULL", as callback shows it)
+    /// </summary>
+    void append(sqlite3_stmt* statement)
+    {
+        char digits[24];
+
+        for (int column = 0; column < column_count; ++column)
+        {
+            // asking SQLite for a value as text makes it convert numbers, and copy text out of the table to add the
+            // terminator it promises, every row. numbers are formatted here instead, and text read in place. the
+            // value is fetched once, as every sqlite3_column_ call locks the connection (reading it unlocked is fine
+            // while one thread at a time uses the connection, as it is here).
+            sqlite3_value* value = sqlite3_column_value(statement, column);
+            std::string_view value_text;
+            switch (sqlite3_value_type(value))
+            {
+            case SQLITE_NULL:
+                value_text = "NULL";
+                break;
+            case SQLITE_INTEGER:
+            {
+                const char* end = std::to_chars(digits, digits + sizeof(digits), sqlite3_value_int64(value)).ptr;
+                value_text = std::string_view(digits, static_cast<size_t>(end - digits));
+                break;
+            }
+            case SQLITE_FLOAT:
+                value_text = reinterpret_cast<const char*>(sqlite3_value_text(value));
+                break;
+            default:
+            {
+                const void* bytes = sqlite3_value_blob(value);
+                const size_t length = static_cast<size_t>(sqlite3_value_bytes(value));
+                value_text = length == 0 ? std::string_view() : std::string_view(static_cast<const char*>(bytes), length);
+                break;
+            }
+            }
+
+            columns[column].push_back({ text.length(), value_text.length() });
+            text.append(value_text);
+        }
+        ++rows;
+    }
+
+private:
+    static constexpr int id_column = 0;
+    static constexpr int name_column = 1;
+    static constexpr int password_column = 2;
+    static constexpr int column_count = 3;
+
+    // where a value's text sits in the block; offsets rather than views, as the block moves when it grows
+    struct extent
+    {
+        size_t offset;
+        size_t length;
+    };
+
+    std::string_view value(int column, size_t row) const
+    {
+        const extent& found = columns[column][row];
+        return std::string_view(text).substr(found.offset, found.length);
+    }
+
+    std::string text;
+    std::vector< extent > columns[column_count];
+    size_t rows = 0;
+};
+
+/// <summary>
+/// run_prepared_query into a user_result_set, which is cleared first and reuses its memory
+/// </summary>
+bool read_prepared_query(statement_cache& statements, const std::string& sql, const std::vector< std::string >& parameters, user_result_set& results)
+{
+    results.clear();
+
+    return step_prepared_query(statements, sql, parameters, [&results](sqlite3_stmt* statement) { results.append(statement); });
+}
+
+/// <summary>
+/// dump_results for a user_result_set, in the same format
+/// </summary>
+void dump_results(const std::string& sql, const user_result_set& results)
+{
+    std::cout << std::endl << "SQL: " << sql << " ==> " << results.size() << " records found." << std::endl;
+
+    for (size_t row = 0; row < results.size(); ++row)
+    {
+        std::cout << "User: " << results.name(row) << " [UID=" << results.id(row) << " PWD=" << results.password(row) << "]\n";
+    }
+    std::cout.flush();
+}
+
+/// <summary>
+/// the NAME='Fred' lookup from run_queries as a prepared statement, then with each of run_query_injection's tautologies
+/// worked into the name: bound as a value it is just a name no user has, so there is nothing to block
+/// </summary>
+void run_prepared_queries(sqlite3* db)
+{
+    statement_cache statements(db, 16);
+    user_result_set results;
+
+    const std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME=?1";
+    for (const std::string name : { "Fred", "Fred' or 2=2;--", "Fred' or 1=1;--", "Fred' or 'hi'='hi", "Fred' or 'hack'='hack" })
+    {
+        if (!read_prepared_query(statements, sql, { name }, results)) return;
+        dump_results(sql + " [?1=" + name + "]", results);
+    }
+
+    std::cout << std::endl << "Prepared statements: " << statements.misses() << " prepared, " << statements.hits() << " reused." << std::endl;
+}
+
+/// <summary>
+/// append sql to key in a form that is the same for queries differing only in the case of their keywords and names,
+/// their spacing, or a trailing semicolon: outside quotes and comments, ASCII letters are lowercased and each run of
+/// white space becomes one space. quoted text ('...', "...", `...` and [...]) may be a value and is copied as it is,
+/// as are comments, so a quote inside one is not taken as the start of a string.
+/// </summary>
+static void normalize_sql(std::string_view sql, std::string& key)
+{
+    const size_t start = key.length();
+
+    for (size_t i = 0; i < sql.length(); ++i)
+    {
+        const char c = sql[i];
+        size_t end = i;
+
+        if (c == '\'' || c == '"' || c == '`' || c == '[')
+        {
+            // a doubled quote closes then reopens, which copies through the same
+            end = sql.find(c == '[' ? ']' : c, i + 1);
+        }
+        else if (sql.substr(i, 2) == "--")
+        {
+            end = sql.find('\n', i + 2);
+        }
+        else if (sql.substr(i, 2) == "/*")
+        {
+            end = sql.find("*/", i + 2);
+            if (end != std::string_view::npos) ++end;
+        }
+        else if (is_space_character(static_cast<unsigned char>(c)))
+        {
+            if (key.length() > start && key.back() != ' ') key += ' ';
+            continue;
+        }
+        else
+        {
+            key += static_cast<char>(screen_lower(c));
+            continue;
+        }
+
+        // the quoted text or comment, through its closing quote or its end, or to the end of sql if it has none
+        end = std::min(end, sql.length() - 1);
+        key.append(sql.substr(i, end - i + 1));
+        i = end;
+    }
+
+    while (key.length() > start && (key.back() == ' ' || key.back() == ';'))
+    {
+        key.pop_back();
+    }
+}
+
+/// <summary>
+/// read-through cache of query results for one connection, least recently used first out. a query's rows are kept as
+/// an immutable record set shared with every caller, so a repeated query costs a hash lookup and no copying, and a
+/// caller can keep its rows for as long as it likes. a generation counter, bumped whenever the database is seen to
+/// have changed, makes every result cached before it stale. each lookup checks for a change by comparing:
+/// - the rows the connection has written, as SQLite counts them (so a DELETE that empties a table in one go counts)
+/// - the database file's data version, which moves with every commit: CREATE, DROP, and other connections' writes
+/// - whether a transaction is open, and while one is, the schema version, which DDL changes before it commits
+/// a commit by another connection only moves the data version once this connection next reads the database, so call
+/// invalidate() after one to be sure. the cache, like the connection, belongs to one thread at a time, and has to be
+/// destroyed before the connection is closed.
+/// </summary>
+class result_cache
+{
+public:
+    typedef std::shared_ptr< const std::vector< user_record > > shared_records;
+
+    result_cache(sqlite3* db, size_t capacity) : db(db), capacity(capacity)
+    {
+    }
+
+    ~result_cache()
+    {
+        sqlite3_finalize(schema_version_statement);
+    }
+
+    result_cache(const result_cache&) = delete;
+    result_cache& operator=(const result_cache&) = delete;
+
+    /// <summary>
+    /// the rows of sql, cached, or from run_query (so screened for injection) if it has not run since the last write
+    /// </summary>
+    bool query(const std::string& sql, shared_records& records)
+    {
+        key.clear();
+        normalize_sql(sql, key);
+
+        return read_through(records, [&](std::vector< user_record >& rows) { return run_query(db, sql, rows); }, sql);
+    }
+
+    /// <summary>
+    /// the rows of a parameterized query, cached, or from run_prepared_query if it has not run with these parameters
+    /// since the last write
+    /// </summary>
+    bool query(statement_cache& statements, const std::string& sql, const std::vector< std::string >& parameters, shared_records& records)
+    {
+        key.clear();
+        normalize_sql(sql, key);
+
+        // SQL text cannot hold a NUL, and each parameter is prefixed by its length, so no two queries share a key
+        for (const std::string& parameter : parameters)
+        {
+            key += '\0';
+            key += std::to_string(parameter.length());
+            key += ':';
+            key += parameter;
+        }
+
+        return read_through(records, [&](std::vector< user_record >& rows) { return run_prepared_query(statements, sql, parameters, rows); }, sql);
+    }
+
+    /// <summary>
+    /// make every cached result stale, for writes this connection did not see
+    /// </summary>
+    void invalidate() { ++generation; }
+
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+
+private:
+    struct cached_result
+    {
+        std::string key;
+        shared_records records;
+        size_t generation;
+    };
+
+    // what check_version compares (see the class comment)
+    struct database_version
+    {
+        sqlite3_int64 changes = -1;
+        unsigned int data_version = 0;
+        // -1 when no transaction is open
+        int schema_version = -1;
+
+        bool operator!=(const database_version& other) const
+        {
+            return changes != other.changes || data_version != other.data_version || schema_version != other.schema_version;
+        }
+    };
+
+    // make every cached result stale if the database has changed since the last check
+    void check_version()
+    {
+        database_version now;
+        now.changes = sqlite3_total_changes64(db);
+        sqlite3_file_control(db, "main", SQLITE_FCNTL_DATA_VERSION, &now.data_version);
+
+        // the schema version has to be queried, so only while a transaction hides DDL from the data version
+        if (!sqlite3_get_autocommit(db))
+        {
+            if (schema_version_statement == NULL)
+            {
+                sqlite3_prepare_v2(db, "PRAGMA schema_version;", -1, &schema_version_statement, NULL);
+            }
+            if (schema_version_statement != NULL)
+            {
+                if (sqlite3_step(schema_version_statement) == SQLITE_ROW)
+                {
+                    now.schema_version = sqlite3_column_int(schema_version_statement, 0);
+                }
+                sqlite3_reset(schema_version_statement);
+            }
+        }
+
+        if (now != version)
+        {
+            version = now;
+            invalidate();
+        }
+    }
+
+    // whether every statement in sql only reads, so its results can be kept
+    bool is_read_only(const std::string& sql) const
+    {
+        const char* next = sql.c_str();
+        while (*next != '\0')
+        {
+            sqlite3_stmt* statement = NULL;
+            if (sqlite3_prepare_v2(db, next, -1, &statement, &next) != SQLITE_OK) return false;
+
+            const bool read_only = statement == NULL || sqlite3_stmt_readonly(statement);
+            sqlite3_finalize(statement);
+            if (!read_only) return false;
+        }
+        return true;
+    }
+
+    template <typename RunQuery>
+    bool read_through(shared_records& records, RunQuery&& run, const std::string& sql)
+    {
+        check_version();
+
+        const auto found = index.find(key);
+        if (found != index.end() && found->second->generation == generation)
+        {
+            // move it to the front, it is now the most recently used
+            recent.splice(recent.begin(), recent, found->second);
+            ++hit_count;
+            records = found->second->records;
+            return true;
+        }
+
+        ++miss_count;
+
+        // a write, or anything else that is not a plain read (CREATE, DROP, ...), is run but not kept, and makes
+        // everything kept before it stale
+        const bool read_only = is_read_only(sql);
+        const size_t run_generation = generation;
+
+        auto rows = std::make_shared< std::vector< user_record > >();
+        if (!run(*rows))
+        {
+            return false;
+        }
+        records = std::move(rows);
+
+        // a write, through a query that looked read-only (a function with side effects, say) or not, is not kept
+        check_version();
+        if (!read_only || generation != run_generation)
+        {
+            invalidate();
+            return true;
+        }
+
+        if (found != index.end())
+        {
+            // a stale result for the same query, replaced
+            found->second->records = records;
+            found->second->generation = generation;
+            recent.splice(recent.begin(), recent, found->second);
+            return true;
+        }
+
+        recent.push_front({ key, records, generation });
+        index.emplace(key, recent.begin());
+
+        // forget the least recently used result; its callers keep their rows
+        if (recent.size() > capacity)
+        {
+            index.erase(recent.back().key);
+            recent.pop_back();
+        }
+
+        return true;
+    }
+
+    sqlite3* const db;
+    const size_t capacity;
+    std::list<cached_result> recent;
+    std::unordered_map<std::string, std::list<cached_result>::iterator> index;
+    std::string key;
+    database_version version;
+    sqlite3_stmt* schema_version_statement = NULL;
+    size_t generation = 0;
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+};
+
+/// <summary>
+/// the NAME='Fred' lookup from run_queries through a result cache: only the first run reaches SQLite, until a new Fred
+/// is inserted and the cached rows go stale
+/// </summary>
+void run_cached_queries(sqlite3* db)
+{
+    result_cache results(db, 64);
+    result_cache::shared_records records;
+
+    const std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred'";
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!results.query(sql, records)) return;
+    }
+    dump_results(sql, *records);
+
+    if (!results.query("INSERT INTO USERS (ID, NAME, PASSWORD) VALUES (5, 'Fred', 'Astaire');", records)) return;
+
+    if (!results.query(sql, records)) return;
+    dump_results(sql, *records);
+
+    std::cout << std::endl << "Result cache: " << results.hits() << " hits, " << results.misses() << " misses." << std::endl;
+}
+
+/// <summary>
+/// the longest NAME or PASSWORD a bulk load accepts, well within what SQLite can bind (an int's worth of bytes) and
+/// what a reader should allocate on a length it has only read from its input
+/// </summary>
+constexpr size_t max_user_text_length = 1 << 20;
+
+/// <summary>
+/// one USERS row on its way into the table. the text is a view into whichever reader produced it, and stays valid
+/// until that reader's next call to next().
+/// </summary>
+struct user_row
+{
+    sqlite3_int64 id;
+    std::string_view name;
+    std::string_view password;
+};
+
+/// <summary>
+/// reads user_rows from CSV text, one ID,NAME,PASSWORD line per user. a field may be quoted to hold commas, quotes
+/// (doubled) or line breaks, and a first line that does not start with a number is taken as a header and skipped.
+/// </summary>
+class csv_user_reader
+{
+public:
+    explicit csv_user_reader(std::istream& input) : input(input)
+    {
+    }
+
+    /// <summary>
+    /// the next row in the input
+    /// </summary>
+    /// <returns>false at the end of the input, or at a line that is not a row (error() then says why)</returns>
+    bool next(user_row& row)
+    {
+        while (read_line())
+        {
+            // blank lines are skipped
+            if (line.empty()) continue;
+
+            if (!split_line())
+            {
+                return false;
+            }
+
+            const std::string& id = fields[0];
+            const auto parsed = std::from_chars(id.data(), id.data() + id.length(), row.id);
+            if (parsed.ec != std::errc() || parsed.ptr != id.data() + id.length())
+            {
+                if (first_line == 1)
+                {
+                    // a header
+                    continue;
+                }
+                error = "line " + std::to_string(first_line) + ": ID is not a whole number";
+                return false;
+            }
+
+            row.name = fields[1];
+            row.password = fields[2];
+            ++rows_read;
+            return true;
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// why next() stopped early, or empty if it reached the end of the input
+    /// </summary>
+    const std::string& last_error() const { return error; }
+
+private:
+    static constexpr size_t field_count = 3;
+
+    // the next line into line, with the lines after it appended while a quoted field is still open
+    bool read_line()
+    {
+        if (!std::getline(input, line)) return false;
+        first_line = ++line_number;
+
+        std::string continuation;
+        while (std::count(line.begin(), line.end(), '"') % 2 != 0 && std::getline(input, continuation))
+        {
+            line += '\n';
+            line += continuation;
+            ++line_number;
+        }
+
+        // text written on Windows
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+    }
+
+    // line into fields, unquoting as it goes. the fields keep their memory from row to row.
+    bool split_line()
+    {
+        size_t field = 0;
+        fields[0].clear();
+        bool quoted = false;
+        for (size_t i = 0; i < line.length(); ++i)
+        {
+            const char c = line[i];
+            if (quoted)
+            {
+                if (c != '"')
+                {
+                    fields[field] += c;
+                }
+                else if (i + 1 < line.length() && line[i + 1] == '"')
+                {
+                    fields[field] += '"';
+                    ++i;
+                }
+                else
+                {
+                    quoted = false;
+                }
+            }
+            else if (c == '"')
+            {
+                quoted = true;
+            }
+            else if (c == ',')
+            {
+                if (++field == field_count) break;
+                fields[field].clear();
+            }
+            else
+            {
+                fields[field] += c;
+            }
+        }
+
+        if (quoted || field != field_count - 1)
+        {
+            error = "line " + std::to_string(first_line) + ": expected ID,NAME,PASSWORD";
+            return false;
+        }
+        return true;
+    }
+
+    std::istream& input;
+    std::string line;
+    std::string fields[field_count];
+    std::string error;
+    size_t line_number = 0;
+    size_t first_line = 0;
+    size_t rows_read = 0;
+};
+
+/// <summary>
+/// reads user_rows written by write_user_row: each is its ID as 8 bytes, then NAME and PASSWORD each as a 4 byte
+/// length and that many bytes, every number little endian. nothing needs parsing or unquoting, so it loads faster
+/// than CSV.
+/// </summary>
+class binary_user_reader
+{
+public:
+    explicit binary_user_reader(std::istream& input) : input(input)
+    {
+    }
+
+    /// <summary>
+    /// the next row in the input
+    /// </summary>
+    /// <returns>false at the end of the input, or at a row cut short or too long (error() then says so)</returns>
+    bool next(user_row& row)
+    {
+        unsigned char id[8];
+        if (!input.read(reinterpret_cast<char*>(id), sizeof(id)))
+        {
+            if (input.gcount() != 0) error = "row " + std::to_string(rows_read + 1) + " is cut short";
+            return false;
+        }
+
+        if (!read_text(name) || !read_text(password))
+        {
+            return false;
+        }
+
+        sqlite3_uint64 value = 0;
+        for (int i = 7; i >= 0; --i)
+        {
+            value = (value << 8) | id[i];
+        }
+        row.id = static_cast<sqlite3_int64>(value);
+        row.name = name;
+        row.password = password;
+        ++rows_read;
+        return true;
+    }
+
+    /// <summary>
+    /// why next() stopped early, or empty if it reached the end of the input
+    /// </summary>
+    const std::string& last_error() const { return error; }
+
+private:
+    bool read_text(std::string& text)
+    {
+        unsigned char bytes[4];
+        if (!input.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+        {
+            error = "row " + std::to_string(rows_read + 1) + " is cut short";
+            return false;
+        }
+
+        // the length is only what the file says, so it is checked before anything is allocated for it
+        const size_t length = static_cast<size_t>(bytes[0]) | static_cast<size_t>(bytes[1]) << 8
+            | static_cast<size_t>(bytes[2]) << 16 | static_cast<size_t>(bytes[3]) << 24;
+        if (length > max_user_text_length)
+        {
+            error = "row " + std::to_string(rows_read + 1) + " has a " + std::to_string(length) + " byte field, longer than "
+                + std::to_string(max_user_text_length);
+            return false;
+        }
+
+        text.resize(length);
+        if (!input.read(text.data(), static_cast<std::streamsize>(length)))
+        {
+            error = "row " + std::to_string(rows_read + 1) + " is cut short";
+            return false;
+        }
+        return true;
+    }
+
+    std::istream& input;
+    std::string name;
+    std::string password;
+    std::string error;
+    size_t rows_read = 0;
+};
+
+/// <summary>
+/// write a row in the form binary_user_reader reads
+/// </summary>
+void write_user_row(std::ostream& output, const user_row& row)
+{
+    char bytes[8];
+    sqlite3_uint64 id = static_cast<sqlite3_uint64>(row.id);
+    for (char& byte : bytes)
+    {
+        byte = static_cast<char>(id & 0xff);
+        id >>= 8;
+    }
+    output.write(bytes, 8);
+
+    for (const std::string_view text : { row.name, row.password })
+    {
+        const uint32_t length = static_cast<uint32_t>(text.length());
+        for (int i = 0; i < 4; ++i)
+        {
+            bytes[i] = static_cast<char>((length >> (8 * i)) & 0xff);
+        }
+        output.write(bytes, 4);
+        output.write(text.data(), static_cast<std::streamsize>(text.length()));
+    }
+}
+
+/// <summary>
+/// made up users for load tests, with IDs counting up from first_id: user<ID> with the password password<ID>
+/// </summary>
+class generated_user_reader
+{
+public:
+    generated_user_reader(sqlite3_int64 first_id, size_t count) : next_id(first_id), remaining(count)
+    {
+    }
+
+    bool next(user_row& row)
+    {
+        if (remaining == 0) return false;
+        --remaining;
+
+        row.id = next_id++;
+        row.name = format(name, "user", row.id);
+        row.password = format(password, "password", row.id);
+        return true;
+    }
+
+    /// <summary>
+    /// always empty, a generated row cannot be malformed
+    /// </summary>
+    const std::string& last_error() const { return error; }
+
+private:
+    static std::string_view format(char (&buffer)[32], std::string_view prefix, sqlite3_int64 id)
+    {
+        std::memcpy(buffer, prefix.data(), prefix.length());
+        const char* end = std::to_chars(buffer + prefix.length(), buffer + sizeof(buffer), id).ptr;
+        return std::string_view(buffer, static_cast<size_t>(end - buffer));
+    }
+
+    sqlite3_int64 next_id;
+    size_t remaining;
+    char name[32];
+    char password[32];
+    std::string error;
+};
+
+/// <summary>
+/// how the connection is set up for a bulk load. the defaults trade durability for speed: the rollback journal is kept
+/// in memory and nothing is synced, which is what a load test's scratch database wants and a real one does not (an
+/// in-memory database keeps its journal in memory whatever it is set to). the settings are left on the connection
+/// afterwards.
+/// </summary>
+struct bulk_load_options
+{
+    // PRAGMA journal_mode: DELETE, TRUNCATE, PERSIST, MEMORY or WAL. not OFF: without a journal a failed load cannot be
+    // rolled back, and trying to can corrupt the database.
+    std::string journal_mode = "MEMORY";
+
+    // PRAGMA synchronous: OFF, NORMAL, FULL or EXTRA
+    std::string synchronous = "OFF";
+
+    // PRAGMA cache_size: pages if positive, KiB if negative
+    int cache_size = -65536;
+};
+
+/// <summary>
+/// whether value is one of the keywords a PRAGMA takes, ignoring case. PRAGMA values cannot be bound as parameters,
+/// so only these ever reach the SQL.
+/// </summary>
+static bool is_pragma_keyword(std::string_view value, std::initializer_list<std::string_view> keywords)
+{
+    return std::any_of(keywords.begin(), keywords.end(), [value](std::string_view keyword)
+    {
+        return value.length() == keyword.length() && std::equal(value.begin(), value.end(), keyword.begin(),
+            [](char a, char b) { return screen_lower(a) == screen_lower(b); });
+    });
+}
+
+/// <summary>
+/// run sql that returns nothing the caller needs
+/// </summary>
+static bool run_statement(sqlite3* db, const std::string& sql)
+{
+    char* error_message = NULL;
+    if (sqlite3_exec(db, sql.c_str(), NULL, NULL, &error_message) != SQLITE_OK)
+    {
+        std::cout << "Bulk load failed. ERROR = " << error_message << std::endl;
+        sqlite3_free(error_message);
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// insert every row a reader (csv_user_reader, binary_user_reader, generated_user_reader) produces into USERS, then
+/// report how many and how fast. initialize_database runs a separate INSERT, each its own transaction, for every row:
+/// here one INSERT is prepared once and only has each row bound to it, and every row goes in one transaction, so
+/// SQLite writes the journal and syncs once rather than once a row. if any row fails, including a bad one from the
+/// reader, none are loaded.
+/// Logic is:
+/// 1) set the PRAGMAs, which have to be set outside a transaction
+/// 2) BEGIN, and prepare the INSERT
+/// 3) bind, step and reset for each row; the text is bound in place, it is still valid while the row is stepped
+/// 4) COMMIT, or ROLLBACK at the first failure
+/// </summary>
+template <typename UserReader>
+bool bulk_load_users(sqlite3* db, UserReader& reader, const bulk_load_options& options = bulk_load_options())
+{
+    if (!is_pragma_keyword(options.journal_mode, { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL" })
+        || !is_pragma_keyword(options.synchronous, { "OFF", "NORMAL", "FULL", "EXTRA" }))
+    {
+        std::cout << "Bulk load failed. ERROR = unknown journal_mode or synchronous setting (journal_mode OFF cannot roll a failed load back)" << std::endl;
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!run_statement(db, "PRAGMA journal_mode=" + options.journal_mode + "; PRAGMA synchronous=" + options.synchronous
+        + "; PRAGMA cache_size=" + std::to_string(options.cache_size) + ";"))
+    {
+        return false;
+    }
+
+    if (!run_statement(db, "BEGIN;"))
+    {
+        return false;
+    }
+
+    sqlite3_stmt* insert = NULL;
+    if (sqlite3_prepare_v2(db, "INSERT INTO USERS (ID, NAME, PASSWORD) VALUES (?1, ?2, ?3);", -1, &insert, NULL) != SQLITE_OK)
+    {
+        std::cout << "Bulk load failed. ERROR = " << sqlite3_errmsg(db) << std::endl;
+        run_statement(db, "ROLLBACK;");
+        return false;
+    }
+
+    size_t rows = 0;
+    user_row row;
+    bool loaded = true;
+    while (reader.next(row))
+    {
+        // a CSV field can be as long as its line, and a reader of another kind longer
+        if (row.name.length() > max_user_text_length || row.password.length() > max_user_text_length)
+        {
+            std::cout << "Bulk load failed at ID " << row.id << ". ERROR = field longer than " << max_user_text_length << " bytes" << std::endl;
+            loaded = false;
+            break;
+        }
+
+        sqlite3_bind_int64(insert, 1, row.id);
+        sqlite3_bind_text(insert, 2, row.name.data(), static_cast<int>(row.name.length()), SQLITE_STATIC);
+        sqlite3_bind_text(insert, 3, row.password.data(), static_cast<int>(row.password.length()), SQLITE_STATIC);
+
+        const int result = sqlite3_step(insert);
+        sqlite3_reset(insert);
+        if (result != SQLITE_DONE)
+        {
+            std::cout << "Bulk load failed at ID " << row.id << ". ERROR = " << sqlite3_errmsg(db) << std::endl;
+            loaded = false;
+            break;
+        }
+        ++rows;
+    }
+    sqlite3_finalize(insert);
+
+    if (loaded && !reader.last_error().empty())
+    {
+        std::cout << "Bulk load failed. ERROR = " << reader.last_error() << std::endl;
+        loaded = false;
+    }
+
+    if (!loaded)
+    {
+        run_statement(db, "ROLLBACK;");
+        return false;
+    }
+
+    if (!run_statement(db, "COMMIT;"))
+    {
+        run_statement(db, "ROLLBACK;");
+        return false;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Bulk loaded " << rows << " users in " << seconds << " seconds ("
+        << static_cast<size_t>(seconds > 0 ? rows / seconds : 0) << " rows/sec)." << std::endl;
+    return true;
+}
+
+/// <summary>
+/// whether text is a whole number, nothing before or after it, that fits a size_t: a count given on the command line
+/// </summary>
+static bool parse_count(std::string_view text, size_t& count)
+{
+    const auto parsed = std::from_chars(text.data(), text.data() + text.length(), count);
+    return parsed.ec == std::errc() && parsed.ptr == text.data() + text.length();
+}
+
+/// <summary>
+/// bulk load a file into a database of its own: a .bin file as binary_user_reader reads it, anything else as CSV,
+/// or, when source is a number, that many generated users
+/// </summary>
+int run_bulk_load(const std::string& source)
+{
+    sqlite3* db = NULL;
+    if (sqlite3_open(":memory:", &db) != SQLITE_OK)
+    {
+        std::cout << "Failed to connect to the database. ERROR=" << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return -1;
+    }
+
+    bool loaded = run_statement(db, "CREATE TABLE USERS(ID INT PRIMARY KEY NOT NULL, NAME TEXT NOT NULL, PASSWORD TEXT NOT NULL);");
+    if (loaded)
+    {
+        size_t count = 0;
+        if (parse_count(source, count))
+        {
+            generated_user_reader reader(1, count);
+            loaded = bulk_load_users(db, reader);
+        }
+        else
+        {
+            std::ifstream input(source, std::ios::binary);
+            if (!input)
+            {
+                std::cout << "Failed to open " << source << std::endl;
+                loaded = false;
+            }
+            else if (source.length() >= 4 && source.compare(source.length() - 4, 4, ".bin") == 0)
+            {
+                binary_user_reader reader(input);
+                loaded = bulk_load_users(db, reader);
+            }
+            else
+            {
+                csv_user_reader reader(input);
+                loaded = bulk_load_users(db, reader);
+            }
+        }
+    }
+
+    // indexed after the load, quicker than updating the index with every row
+    loaded = loaded && create_lookup_indexes(db);
+
+    sqlite3_close(db);
+    return loaded ? 0 : -1;
+}
+
+/// <summary>
+/// a fixed set of connections to one database, each lent to one thread at a time along with its own statement cache.
+/// for the connections to share data the database has to be a file (put in WAL mode here, so readers do not wait on
+/// each other or on a writer) or a shared-cache in-memory one, "file:name?mode=memory&cache=shared"; plain ":memory:"
+/// would give every connection a database of its own.
+/// </summary>
+class connection_pool
+{
+    struct pooled_connection
+    {
+        pooled_connection(sqlite3* db, size_t cached_statements) : db(db), statements(db, cached_statements)
+        {
+        }
+
+        sqlite3* const db;
+        statement_cache statements;
+    };
+
+public:
+    /// <summary>
+    /// a connection on loan from the pool, handed back when the lease goes out of scope
+    /// </summary>
+    class lease
+    {
+    public:
+        lease(lease&& other) noexcept : pool(other.pool), connection(other.connection)
+        {
+            other.connection = NULL;
+        }
+
+        ~lease()
+        {
+            if (connection != NULL)
+            {
+                pool->release(connection);
+            }
+        }
+
+        lease(const lease&) = delete;
+        lease& operator=(const lease&) = delete;
+        lease& operator=(lease&&) = delete;
+
+        sqlite3* db() const { return connection->db; }
+        statement_cache& statements() const { return connection->statements; }
+
+    private:
+        friend class connection_pool;
+
+        lease(connection_pool* pool, pooled_connection* connection) : pool(pool), connection(connection)
+        {
+        }
+
+        connection_pool* pool;
+        pooled_connection* connection;
+    };
+
+    /// <summary>
+    /// open size connections to filename (a path or a file: URI), each caching up to cached_statements statements.
+    /// check is_open() before use; if any connection fails to open none are kept, and last_error() says why.
+    /// </summary>
+    connection_pool(const std::string& filename, size_t size, size_t cached_statements = 16)
+    {
+        // a connection is only ever used by one thread at a time, so SQLite's own locking of it is not needed
+        const int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            sqlite3* db = NULL;
+            if (sqlite3_open_v2(filename.c_str(), &db, flags, NULL) != SQLITE_OK)
+            {
+                error = "failed to open " + filename + ". ERROR = " + sqlite3_errmsg(db);
+                sqlite3_close(db);
+                close_all();
+                return;
+            }
+
+            // wait on a writer rather than fail straight away, and let readers run alongside it. an in-memory
+            // database keeps its own journal mode, which is fine.
+            sqlite3_busy_timeout(db, 5000);
+            sqlite3_exec(db, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
+
+            connections.push_back(std::make_unique<pooled_connection>(db, cached_statements));
+            idle.push_back(connections.back().get());
+        }
+    }
+
+    ~connection_pool()
+    {
+        close_all();
+    }
+
+    connection_pool(const connection_pool&) = delete;
+    connection_pool& operator=(const connection_pool&) = delete;
+
+    bool is_open() const { return !connections.empty(); }
+    const std::string& last_error() const { return error; }
+    size_t size() const { return connections.size(); }
+
+    /// <summary>
+    /// borrow a connection, waiting for one to be handed back if they are all on loan
+    /// </summary>
+    lease acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this] { return !idle.empty(); });
+
+        pooled_connection* connection = idle.back();
+        idle.pop_back();
+        return lease(this, connection);
+    }
+
+private:
+    void release(pooled_connection* connection)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            idle.push_back(connection);
+        }
+        available.notify_one();
+    }
+
+    void close_all()
+    {
+        for (auto& connection : connections)
+        {
+            // the statements have to be finalized before their connection closes
+            sqlite3* db = connection->db;
+            connection.reset();
+            sqlite3_close(db);
+        }
+        connections.clear();
+        idle.clear();
+    }
+
+    std::vector< std::unique_ptr<pooled_connection> > connections;
+    std::vector< pooled_connection* > idle;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::string error;
+};
+
+/// <summary>
+/// one query for run_concurrent_queries: SQL text for run_query, or parameterized SQL for read_prepared_query
+/// </summary>
+struct load_query
+{
+    std::string sql;
+    std::vector< std::string > parameters;
+    bool prepared;
+};
+
+/// <summary>
+/// what run_concurrent_queries measured: how long each query took, in the order given, and how many were refused
+/// (blocked as injections, or failed)
+/// </summary>
+struct load_result
+{
+    std::vector< std::chrono::nanoseconds > latencies;
+    std::chrono::nanoseconds elapsed{};
+    size_t refused = 0;
+};
+
+/// <summary>
+/// run queries across thread_count threads (no more than the pool has connections), the calling thread being one.
+/// each thread borrows a connection for as long as it runs, so the connection's statement cache is that thread's own
+/// and nothing is shared between queries except the pool, once per thread.
+/// </summary>
+load_result run_concurrent_queries(connection_pool& pool, const std::vector< load_query >& queries, size_t thread_count)
+{
+    thread_count = std::max<size_t>(1, std::min(thread_count, pool.size()));
+
+    load_result result;
+    result.latencies.resize(queries.size());
+    std::atomic<size_t> next_query(0);
+    std::atomic<size_t> refused(0);
+
+    const auto worker = [&]()
+    {
+        const connection_pool::lease connection = pool.acquire();
+        std::vector< user_record > records;
+        user_result_set results;
+        size_t refused_here = 0;
+
+        for (size_t i = next_query++; i < queries.size(); i = next_query++)
+        {
+            const load_query& query = queries[i];
+
+            const auto start = std::chrono::steady_clock::now();
+            const bool succeeded = query.prepared
+                ? read_prepared_query(connection.statements(), query.sql, query.parameters, results)
+                : run_query(connection.db(), query.sql, records);
+            result.latencies[i] = std::chrono::steady_clock::now() - start;
+
+            if (!succeeded) ++refused_here;
+        }
+        refused += refused_here;
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector< std::thread > threads;
+    for (size_t i = 1; i < thread_count; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    result.elapsed = std::chrono::steady_clock::now() - start;
+    result.refused = refused;
+    return result;
+}
+
+/// <summary>
+/// run_queries' queries, rounds times over: everything, NAME='Fred', then five of run_query_injection's tautologies
+/// picked at random (seeded, so every run replays the same mix). as SQL text the injections are appended to the query,
+/// as run_query_injection does, and run_query blocks them; prepared, they are worked into the bound name, which then
+/// matches nobody.
+/// </summary>
+std::vector< load_query > make_query_mix(size_t rounds, bool prepared, unsigned seed)
+{
+    // run_query_injection's tautologies, in the order its switch picks them
+    static const std::string injections[] = { " or 1=1;", " or 2=2;", " or 'hi'='hi';", " or 'hack'='hack';" };
+
+    std::mt19937 generator(seed);
+    std::vector< load_query > queries;
+    queries.reserve(rounds * 7);
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        if (prepared)
+        {
+            queries.push_back({ "SELECT ID, NAME, PASSWORD FROM USERS", {}, true });
+            queries.push_back({ "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME=?1", { "Fred" }, true });
+        }
+        else
+        {
+            queries.push_back({ "SELECT * from USERS", {}, false });
+            queries.push_back({ "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred'", {}, false });
+        }
+
+        for (int i = 0; i < 5; ++i)
+        {
+            const std::string& injection = injections[generator() % 4];
+            if (prepared)
+            {
+                queries.push_back({ "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME=?1", { "Fred'" + injection + "--" }, true });
+            }
+            else
+            {
+                queries.push_back({ "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred'" + injection, {}, false });
+            }
+        }
+    }
+    return queries;
+}
+
+/// <summary>
+/// the latency below which the given percent of queries finished
+/// </summary>
+static std::chrono::nanoseconds latency_percentile(const std::vector< std::chrono::nanoseconds >& sorted, size_t percent)
+{
+    return sorted.empty() ? std::chrono::nanoseconds() : sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)];
+}
+
+/// <summary>
+/// print a load_result as throughput and p50/p99 latency
+/// </summary>
+void report_load(const std::string& label, const load_result& result)
+{
+    std::vector< std::chrono::nanoseconds > sorted(result.latencies);
+    std::sort(sorted.begin(), sorted.end());
+
+    const double seconds = std::chrono::duration<double>(result.elapsed).count();
+    const auto microseconds = [](std::chrono::nanoseconds latency) { return std::chrono::duration<double, std::micro>(latency).count(); };
+
+    std::cout << label << ": " << sorted.size() << " queries in " << seconds << " seconds ("
+        << static_cast<size_t>(seconds > 0 ? sorted.size() / seconds : 0) << " queries/sec), p50 = "
+        << microseconds(latency_percentile(sorted, 50)) << " us, p99 = " << microseconds(latency_percentile(sorted, 99))
+        << " us, " << result.refused << " refused." << std::endl;
+}
+
+/// <summary>
+/// a stream buffer that drops everything written to it, for std::cout while run_query is blocking thousands of
+/// injections from several threads at once
+/// </summary>
+class discard_buffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+/// <summary>
+/// create the exercise's USERS table and its lookup indexes through one of a pool's connections
+/// </summary>
+static bool initialize_users(connection_pool& pool)
+{
+    const connection_pool::lease connection = pool.acquire();
+    return initialize_database(connection.db()) && create_lookup_indexes(connection.db());
+}
+
+/// <summary>
+/// load test the exercise's queries: create USERS in a new database file, then replay rounds of the run_queries mix
+/// across thread_count pooled connections, as SQL text through run_query and then prepared, reporting each.
+/// the file is deleted afterwards, so an existing one is refused rather than overwritten.
+/// </summary>
+int run_load_test(const std::string& filename, size_t thread_count, size_t rounds)
+{
+    if (thread_count == 0 || rounds == 0)
+    {
+        std::cout << "Load test refused: threads and rounds must be at least 1." << std::endl;
+        return -1;
+    }
+
+    if (std::filesystem::exists(filename))
+    {
+        std::cout << "Load test refused: " << filename << " already exists." << std::endl;
+        return -1;
+    }
+
+    bool loaded = false;
+    {
+        connection_pool pool(filename, thread_count);
+        if (!pool.is_open())
+        {
+            std::cout << "Load test failed: " << pool.last_error() << std::endl;
+        }
+        else if (initialize_users(pool))
+        {
+            for (const bool prepared : { false, true })
+            {
+                const std::vector< load_query > queries = make_query_mix(rounds, prepared, 405);
+
+                discard_buffer discarded;
+                std::streambuf* const output = std::cout.rdbuf(&discarded);
+                const load_result result = run_concurrent_queries(pool, queries, thread_count);
+                std::cout.rdbuf(output);
+
+                report_load(std::string(prepared ? "Prepared" : "Screened") + " load, " + std::to_string(pool.size()) + " threads", result);
+            }
+            loaded = true;
+        }
+    }
+
+    for (const char* suffix : { "", "-wal", "-shm" })
+    {
+        std::filesystem::remove(filename + suffix);
+    }
+    return loaded ? 0 : -1;
+}
+
+/// <summary>
+/// screen a SQL file, a batch script say, a block at a time with an injection_screener, and report what it found
+/// </summary>
+/// <returns>0 if it has no tautologies, -1 if it does or cannot be read</returns>
+int run_screen(const std::string& filename)
+{
+    std::ifstream input(filename, std::ios::binary);
+    if (!input)
+    {
+        std::cout << "Failed to open " << filename << std::endl;
+        return -1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    injection_screener screener;
+    std::vector<char> block(64 * 1024);
+    size_t bytes = 0;
+    while (input.read(block.data(), static_cast<std::streamsize>(block.size())) || input.gcount() > 0)
+    {
+        screener.feed(std::string_view(block.data(), static_cast<size_t>(input.gcount())));
+        bytes += static_cast<size_t>(input.gcount());
+    }
+    screener.finish();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Screened " << bytes << " bytes of " << filename << " in " << seconds << " seconds ("
+        << static_cast<size_t>(seconds > 0 ? bytes / seconds / (1024 * 1024) : 0) << " MB/sec): "
+        << screener.statements() << " statements" << (screener.stacked_statements() ? " (stacked)" : "") << ", "
+        << screener.tautologies() << " tautologies";
+    if (screener.tautologies() > 0)
+    {
+        std::cout << ", the first ending at byte " << screener.first_tautology_offset();
+    }
+    std::cout << "." << std::endl;
+
+    return screener.tautologies() > 0 ? -1 : 0;
+}
+
+// You can change main by adding stuff to it, but all of the existing code must remain and be
+// in the order called (with none of this existing code placed into conditional statements)
+int main(int argc, char* argv[])
+{
+    // initialize random seed:
+    srand(time(nullptr));
+
+    int return_code = 0;
+    std::cout << "SQL Injection Example" << std::endl;
+
+    // show the plan of every query: --explain
+    explain_queries = argc > 1 && std::string(argv[1]) == "--explain";
+
+    // the database handle
+    sqlite3* db = NULL;
+    char* error_message = NULL;
+
+    // open the database connection
+    int result = sqlite3_open(":memory:", &db);
+
+    if (result != SQLITE_OK)
+    {
+        std::cout << "Failed to connect to the database and terminating. ERROR=" << sqlite3_errmsg(db) << std::endl;
+        return -1;
+    }
+
+    std::cout << "Connected to the database." << std::endl;
+
+    // initialize our database
+    if (!initialize_database(db))
+    {
+        std::cout << "Database Initialization Failed. Terminating." << std::endl;
+        return_code = -1;
+    }
+    else
+    {
+        // index the columns the queries look users up by
+        create_lookup_indexes(db);
+
+        run_queries(db);
+
+        // the same lookups through prepared statements
+        run_prepared_queries(db);
+
+        // and through a result cache
+        run_cached_queries(db);
+    }
+
+    // close the connection if opened
+    if (db != NULL)
+    {
+        sqlite3_close(db);
+    }
+
+    // bulk load a file, or that many generated users, into a database of its own
+    if (return_code == 0 && argc > 2 && std::string(argv[1]) == "--bulk-load")
+    {
+        return_code = run_bulk_load(argv[2]);
+    }
+
+    // replay the queries above across threads: --load-test [threads] [rounds] [database file]
+    if (return_code == 0 && argc > 1 && std::string(argv[1]) == "--load-test")
+    {
+        size_t thread_count = 4;
+        size_t rounds = 1000;
+        if ((argc > 2 && !parse_count(argv[2], thread_count)) || (argc > 3 && !parse_count(argv[3], rounds)))
+        {
+            std::cout << "Load test refused: threads and rounds must be whole numbers." << std::endl;
+            return_code = -1;
+        }
+        else
+        {
+            return_code = run_load_test(argc > 4 ? argv[4] : (std::filesystem::temp_directory_path() / "sqli_load.db").string(), thread_count, rounds);
+        }
+    }
+
+    // screen a SQL file for injection, however big: --screen <file>
+    if (return_code == 0 && argc > 2 && std::string(argv[1]) == "--screen")
+    {
+        return_code = run_screen(argv[2]);
     }
 
     return return_code;
@@ -0,0 +1,73 @@
+// benchmark_support.h : Helpers shared by the benchmark suites.
+//
+
+#pragma once
+
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+
+// every benchmark generates its data from this seed so results are comparable between runs
+constexpr unsigned benchmark_seed = 405;
+
+/// <summary>
+/// a stream buffer that throws away everything written to it
+/// </summary>
+class null_buffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+/// <summary>
+/// sends std::cout to a null buffer for as long as it lives, so the exercises' console messages
+/// are still formatted (part of the cost being measured) but do not flood the benchmark output
+/// </summary>
+class silence_cout
+{
+public:
+    silence_cout() : previous(std::cout.rdbuf(&discard)) {}
+    ~silence_cout() { std::cout.rdbuf(previous); }
+
+    silence_cout(const silence_cout&) = delete;
+    silence_cout& operator=(const silence_cout&) = delete;
+
+private:
+    null_buffer discard;
+    std::streambuf* previous;
+};
+
+/// <summary>
+/// random bytes from a fixed seed
+/// </summary>
+inline std::string random_bytes(size_t length, unsigned seed = benchmark_seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> byte_distribution(0, 255);
+
+    std::string bytes(length, '\0');
+    for (auto& c : bytes)
+    {
+        c = static_cast<char>(byte_distribution(generator));
+    }
+    return bytes;
+}
+
+/// <summary>
+/// lorem-ipsum-like lowercase text with a line break every 80 characters, from a fixed seed
+/// </summary>
+inline std::string random_text(size_t length, unsigned seed = benchmark_seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> letter_distribution(0, 26);
+
+    std::string text(length, ' ');
+    for (size_t i = 0; i < length; ++i)
+    {
+        const int letter = letter_distribution(generator);
+        text[i] = (i % 80 == 79) ? '\n' : (letter == 26 ? ' ' : static_cast<char>('a' + letter));
+    }
+    return text;
+}
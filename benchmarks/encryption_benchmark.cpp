@@ -0,0 +1,76 @@
+// encryption_benchmark.cpp : Google Benchmark suite for encrypt_decrypt in Encryption.cpp.
+//
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_support.h"
+
+// compile the exercise in with its main renamed, the benchmark library provides this program's main
+#define main encryption_main
+#include "../Encryption.cpp"
+#undef main
+
+// payload sizes from 1 KB to 64 MB, against short, odd, and vector-width keys
+static void encryption_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    for (int64_t payload_length = 1 << 10; payload_length <= 64 << 20; payload_length *= 8)
+    {
+        for (int64_t key_length : { 1, 8, 13, 64 })
+        {
+            benchmark->Args({ payload_length, key_length });
+        }
+    }
+}
+
+// in place transform, the allocation free hot path
+static void BM_encrypt_decrypt_in_place(benchmark::State& state)
+{
+    std::string data = random_bytes(static_cast<size_t>(state.range(0)));
+    const std::string key = random_bytes(static_cast<size_t>(state.range(1)), benchmark_seed + 1);
+
+    for (auto _ : state)
+    {
+        encrypt_decrypt(std::span<char>(data), key);
+        benchmark::DoNotOptimize(data.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_encrypt_decrypt_in_place)->Apply(encryption_sizes);
+
+// the original string in, string out interface
+static void BM_encrypt_decrypt_string(benchmark::State& state)
+{
+    const std::string source = random_bytes(static_cast<size_t>(state.range(0)));
+    const std::string key = random_bytes(static_cast<size_t>(state.range(1)), benchmark_seed + 1);
+
+    for (auto _ : state)
+    {
+        std::string output = encrypt_decrypt(source, key);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_encrypt_decrypt_string)->Apply(encryption_sizes);
+
+// the multi-threaded engine on large payloads, one pool per thread count
+static void BM_encrypt_decrypt_parallel(benchmark::State& state)
+{
+    std::string data = random_bytes(static_cast<size_t>(state.range(0)));
+    const std::string key = "password";
+    thread_pool pool(static_cast<unsigned>(state.range(1)));
+
+    for (auto _ : state)
+    {
+        encrypt_decrypt(std::span<const char>(data), std::span<char>(data), key, pool);
+        benchmark::DoNotOptimize(data.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_encrypt_decrypt_parallel)->ArgsProduct({ { 16 << 20, 256 << 20 }, { 1, 2, 4, 8 } })->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,115 @@
+// exceptions_benchmark.cpp : Google Benchmark suite for the exception handling paths in Mod4_Exceptions.
+//
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_support.h"
+
+// compile the exercise in with its main renamed, the benchmark library provides this program's main
+#define main exceptions_main
+#include "../Mod4_Exceptions (1).cpp"
+#undef main
+
+// divide on the happy path, no exception thrown
+static void BM_divide(benchmark::State& state)
+{
+    float numerator = 10.0f;
+    float denominator = 4.0f;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(numerator);
+        benchmark::DoNotOptimize(denominator);
+        benchmark::DoNotOptimize(divide(numerator, denominator));
+    }
+}
+BENCHMARK(BM_divide);
+
+// divide by zero, thrown as std::runtime_error and caught right away
+static void BM_divide_by_zero(benchmark::State& state)
+{
+    float numerator = 10.0f;
+    float denominator = 0.0f;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(denominator);
+        try {
+            benchmark::DoNotOptimize(divide(numerator, denominator));
+        }
+        catch (const std::runtime_error& e) {
+            benchmark::DoNotOptimize(e.what());
+        }
+    }
+}
+BENCHMARK(BM_divide_by_zero);
+
+// throwing and catching the custom exception type
+static void BM_custom_exception(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        try {
+            throw CustomException("A custom exception occurred when leaving custom application logic. Any questions?");
+        }
+        catch (const CustomException& e) {
+            benchmark::DoNotOptimize(e.what());
+        }
+    }
+}
+BENCHMARK(BM_custom_exception);
+
+// a custom exception caught through a std::exception handler several frames up
+static void BM_custom_exception_unwind(benchmark::State& state)
+{
+    // each level adds a frame the exception has to unwind through
+    struct unwinder
+    {
+        static void throw_from(int depth)
+        {
+            if (depth == 0)
+            {
+                throw CustomException("unwound");
+            }
+            throw_from(depth - 1);
+            benchmark::ClobberMemory();
+        }
+    };
+
+    const auto depth = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        try {
+            unwinder::throw_from(depth);
+        }
+        catch (const std::exception& e) {
+            benchmark::DoNotOptimize(e.what());
+        }
+    }
+}
+BENCHMARK(BM_custom_exception_unwind)->RangeMultiplier(4)->Range(1, 256);
+
+// the exercise's full handlers, console output included but discarded
+static void BM_do_division(benchmark::State& state)
+{
+    const silence_cout quiet;
+
+    for (auto _ : state)
+    {
+        do_division();
+    }
+}
+BENCHMARK(BM_do_division);
+
+static void BM_do_custom_application_logic(benchmark::State& state)
+{
+    const silence_cout quiet;
+
+    for (auto _ : state)
+    {
+        do_custom_application_logic();
+    }
+}
+BENCHMARK(BM_do_custom_application_logic);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,117 @@
+// file_io_benchmark.cpp : Google Benchmark suite for the file handling in Encryption.cpp
+// (read_file / save_data_file and the streaming and memory mapped paths built on them).
+//
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_support.h"
+
+// compile the exercise in with its main renamed, the benchmark library provides this program's main
+#define main encryption_main
+#include "../Encryption.cpp"
+#undef main
+
+// input sizes from 1 KB to 64 MB
+static void file_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(8)->Range(1 << 10, 64 << 20);
+}
+
+/// <summary>
+/// writes a text input file for the length of one benchmark and removes it afterwards
+/// </summary>
+class benchmark_input_file
+{
+public:
+    explicit benchmark_input_file(size_t length) : filename("benchmark_input_" + std::to_string(length) + ".txt")
+    {
+        const std::string text = random_text(length);
+        std::ofstream file(filename, std::ios::binary);
+        file.write(text.data(), text.size());
+    }
+
+    ~benchmark_input_file()
+    {
+        std::remove(filename.c_str());
+    }
+
+    const std::string filename;
+};
+
+static void BM_read_file(benchmark::State& state)
+{
+    const benchmark_input_file input(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        std::string text = read_file(input.filename);
+        benchmark::DoNotOptimize(text.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_file)->Apply(file_sizes);
+
+static void BM_save_data_file(benchmark::State& state)
+{
+    const std::string data = random_text(static_cast<size_t>(state.range(0)));
+    const std::string output_filename = "benchmark_output.txt";
+
+    for (auto _ : state)
+    {
+        save_data_file(output_filename, "John Q. Smith", "password", data);
+    }
+
+    std::remove(output_filename.c_str());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_save_data_file)->Apply(file_sizes);
+
+// read, encrypt, and save: the round trip main does for one file
+static void BM_whole_file_round_trip(benchmark::State& state)
+{
+    const benchmark_input_file input(static_cast<size_t>(state.range(0)));
+    const std::string output_filename = "benchmark_output.txt";
+
+    for (auto _ : state)
+    {
+        const std::string source_string = read_file(input.filename);
+        save_data_file(output_filename, get_student_name(source_string), "password", encrypt_decrypt(source_string, "password"));
+    }
+
+    std::remove(output_filename.c_str());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_whole_file_round_trip)->Apply(file_sizes);
+
+static void BM_encrypt_file_streaming(benchmark::State& state)
+{
+    const benchmark_input_file input(static_cast<size_t>(state.range(0)));
+    const std::string output_filename = "benchmark_output.txt";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(encrypt_file_streaming(input.filename, output_filename, "password"));
+    }
+
+    std::remove(output_filename.c_str());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_encrypt_file_streaming)->Apply(file_sizes);
+
+static void BM_encrypt_file_mapped(benchmark::State& state)
+{
+    const benchmark_input_file input(static_cast<size_t>(state.range(0)));
+    const std::string output_filename = "benchmark_output.txt";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(encrypt_file_mapped(input.filename, output_filename, "password"));
+    }
+
+    std::remove(output_filename.c_str());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_encrypt_file_mapped)->Apply(file_sizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,273 @@
+// numeric_overflow_benchmark.cpp : Google Benchmark suite for the overflow checked arithmetic in NB_OverUnderflow_Fixed.cpp.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark_support.h"
+
+// compile the exercise in with its main renamed, the benchmark library provides this program's main
+#define main numeric_overflows_main
+#include "../NB_OverUnderflow_Fixed.cpp"
+#undef main
+
+// step counts from 1 to 1M
+static void step_counts(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(16)->Range(1, 1 << 20);
+}
+
+// adding all the way without overflowing, the full loop runs
+template <typename T>
+static void BM_add_numbers(benchmark::State& state)
+{
+    const auto steps = static_cast<unsigned long int>(state.range(0));
+    const T increment = static_cast<T>(std::numeric_limits<T>::max() / static_cast<T>(steps + 1));
+    const T start = 0;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(add_numbers<T>(start, increment, steps));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_add_numbers, int)->Apply(step_counts);
+BENCHMARK_TEMPLATE(BM_add_numbers, unsigned int)->Apply(step_counts);
+BENCHMARK_TEMPLATE(BM_add_numbers, long long)->Apply(step_counts);
+BENCHMARK_TEMPLATE(BM_add_numbers, double)->Apply(step_counts);
+
+// subtracting all the way without underflowing, the full loop runs
+template <typename T>
+static void BM_subtract_numbers(benchmark::State& state)
+{
+    const auto steps = static_cast<unsigned long int>(state.range(0));
+    const T decrement = static_cast<T>(std::numeric_limits<T>::max() / static_cast<T>(steps + 1));
+    const T start = std::numeric_limits<T>::max();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(subtract_numbers<T>(start, decrement, steps));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_subtract_numbers, int)->Apply(step_counts);
+BENCHMARK_TEMPLATE(BM_subtract_numbers, unsigned int)->Apply(step_counts);
+BENCHMARK_TEMPLATE(BM_subtract_numbers, long long)->Apply(step_counts);
+BENCHMARK_TEMPLATE(BM_subtract_numbers, double)->Apply(step_counts);
+
+// discards drained overflow events
+static void ignore_overflow_event(const overflow_event&)
+{
+}
+
+// overflow on the last step, so the cost includes detecting and recording it
+template <typename T>
+static void BM_add_numbers_overflow(benchmark::State& state)
+{
+    const auto steps = static_cast<unsigned long int>(state.range(0));
+    const T increment = static_cast<T>(std::numeric_limits<T>::max() / static_cast<T>(steps));
+    const T start = increment;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(add_numbers<T>(start, increment, steps));
+    }
+    drain_overflow_events(ignore_overflow_event);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_add_numbers_overflow, int)->Apply(step_counts);
+BENCHMARK_TEMPLATE(BM_add_numbers_overflow, unsigned int)->Apply(step_counts);
+
+// underflow on the last step, so the cost includes detecting and recording it
+template <typename T>
+static void BM_subtract_numbers_underflow(benchmark::State& state)
+{
+    const auto steps = static_cast<unsigned long int>(state.range(0));
+    const T decrement = static_cast<T>(std::numeric_limits<T>::max() / static_cast<T>(steps));
+    const T start = static_cast<T>(std::numeric_limits<T>::lowest() + decrement * static_cast<T>(steps) - 1);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(subtract_numbers<T>(start, decrement, steps));
+    }
+    drain_overflow_events(ignore_overflow_event);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_subtract_numbers_underflow, unsigned int)->Apply(step_counts);
+
+// an overflow recorded and then drained, as a reporting thread would: once discarded, once formatted to the console
+// (which is where every overflow's cost went when add_numbers printed the message itself)
+static void BM_overflow_event_drained(benchmark::State& state)
+{
+    const bool write_message = state.range(0) != 0;
+    const silence_cout quiet;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(add_numbers<int>(1, std::numeric_limits<int>::max(), 2));
+        if (write_message) {
+            drain_overflow_events(std::cout);
+        }
+        else {
+            drain_overflow_events(ignore_overflow_event);
+        }
+    }
+}
+BENCHMARK(BM_overflow_event_drained)->ArgName("write_message")->Arg(0)->Arg(1);
+
+// batch sizes from 1K to 1M counters
+static void batch_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(32)->Range(1 << 10, 1 << 20);
+}
+
+// counters and updates drawn from the whole range of T, so roughly a quarter of the updates saturate
+template <typename T>
+static std::vector<T> random_counters(size_t count, unsigned seed)
+{
+    std::mt19937_64 generator(seed);
+
+    std::vector<T> values(count);
+    for (auto& value : values)
+    {
+        value = static_cast<T>(generator());
+    }
+    return values;
+}
+
+// the batch API, AVX2 when the CPU has it
+template <typename T>
+static void BM_saturating_add_batch(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(0));
+    const std::vector<T> starts = random_counters<T>(count, benchmark_seed);
+    const std::vector<T> increments = random_counters<T>(count, benchmark_seed + 1);
+    std::vector<T> results(count);
+    std::vector<std::uint64_t> overflow_mask(overflow_mask_words(count));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(saturating_add_batch<T>(starts, increments, results, overflow_mask));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_saturating_add_batch, signed char)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_saturating_add_batch, unsigned short)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_saturating_add_batch, int)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_saturating_add_batch, unsigned int)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_saturating_add_batch, long long)->Apply(batch_sizes);
+
+template <typename T>
+static void BM_saturating_subtract_batch(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(0));
+    const std::vector<T> starts = random_counters<T>(count, benchmark_seed);
+    const std::vector<T> decrements = random_counters<T>(count, benchmark_seed + 1);
+    std::vector<T> results(count);
+    std::vector<std::uint64_t> overflow_mask(overflow_mask_words(count));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(saturating_subtract_batch<T>(starts, decrements, results, overflow_mask));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_saturating_subtract_batch, int)->Apply(batch_sizes);
+BENCHMARK_TEMPLATE(BM_saturating_subtract_batch, unsigned long long)->Apply(batch_sizes);
+
+// the same updates one at a time through add_numbers, the per-scalar checks the batch API replaces
+template <typename T>
+static void BM_add_numbers_per_counter(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(0));
+    const std::vector<T> starts = random_counters<T>(count, benchmark_seed);
+    const std::vector<T> increments = random_counters<T>(count, benchmark_seed + 1);
+    std::vector<T> results(count);
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            results[i] = add_numbers<T>(starts[i], increments[i], 1);
+        }
+        benchmark::ClobberMemory();
+        drain_overflow_events(ignore_overflow_event);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_add_numbers_per_counter, int)->Apply(batch_sizes);
+
+// small non-negative values, so none of the counter loops below ever overflow and only the no-overflow path is measured
+static std::vector<int> counter_updates(size_t count)
+{
+    std::mt19937 generator(benchmark_seed);
+    std::uniform_int_distribution<int> update_distribution(0, 1000);
+
+    std::vector<int> updates(count);
+    for (auto& update : updates)
+    {
+        update = update_distribution(generator);
+    }
+    return updates;
+}
+
+// a counter bumped by each update: a plain int against checked<int> with each policy
+template <typename Counter>
+static void BM_counter_add(benchmark::State& state)
+{
+    const std::vector<int> updates = counter_updates(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        Counter total{};
+        for (const int update : updates)
+        {
+            total += Counter(update);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_counter_add, int)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_add, checked<int>)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_add, checked<int, throw_on_overflow>)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_add, checked<int, flag_on_overflow>)->Arg(4096);
+
+// every operator on each update: total += (update * 3) / 2 - (update >> 1) + (update << 2)
+template <typename Counter>
+static void BM_counter_mixed(benchmark::State& state)
+{
+    const std::vector<int> updates = counter_updates(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        Counter total{};
+        for (const int update : updates)
+        {
+            const Counter value(update);
+            total += (value * Counter(3)) / Counter(2) - (value >> 1) + (value << 2);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_counter_mixed, int)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_mixed, checked<int>)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_mixed, checked<int, throw_on_overflow>)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_mixed, checked<int, flag_on_overflow>)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_mixed, long long)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_counter_mixed, checked<long long>)->Arg(4096);
+
+BENCHMARK_MAIN();
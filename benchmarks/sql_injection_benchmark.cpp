@@ -0,0 +1,489 @@
+// sql_injection_benchmark.cpp : Google Benchmark suite for run_query and its injection screening in NB_SQLi_Revised,
+// the prepared statement path that replaces both, a result cache in front of them, bulk loading users and concurrent
+// queries over a connection pool.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <optional>
+#include <regex>
+#include <sstream>
+
+#include "benchmark_support.h"
+
+// compile the exercise in with its main renamed, the benchmark library provides this program's main
+#define main sql_injection_main
+#include "../NB_SQLi_Revised (1).cpp"
+#undef main
+
+/// <summary>
+/// an in-memory database with the exercise's USERS table, opened for one benchmark
+/// </summary>
+class benchmark_database
+{
+public:
+    benchmark_database()
+    {
+        const silence_cout quiet;
+        sqlite3_open(":memory:", &db);
+        initialize_database(db);
+    }
+
+    ~benchmark_database()
+    {
+        sqlite3_close(db);
+    }
+
+    sqlite3* db = NULL;
+};
+
+// generated users after the exercise's four, up to count in all, so a full read is big enough to show per-row costs
+static void add_users(sqlite3* db, size_t count)
+{
+    std::mt19937 generator(benchmark_seed);
+    sqlite3_stmt* insert = NULL;
+
+    sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+    sqlite3_prepare_v2(db, "INSERT INTO USERS (ID, NAME, PASSWORD) VALUES (?1, ?2, ?3)", -1, &insert, NULL);
+    for (size_t id = 5; id <= count; ++id)
+    {
+        const std::string name = "user" + std::to_string(generator() % 100000);
+        const std::string password = "password" + std::to_string(generator());
+        sqlite3_bind_int64(insert, 1, static_cast<sqlite3_int64>(id));
+        sqlite3_bind_text(insert, 2, name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert, 3, password.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(insert);
+        sqlite3_reset(insert);
+    }
+    sqlite3_finalize(insert);
+    sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+}
+
+// USERS tables from 1K to 64K rows
+static void table_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(8)->Range(1 << 10, 64 << 10);
+}
+
+// the NAME='Fred' lookup from run_queries padded out with harmless conditions to the requested length
+static std::string padded_query(size_t length)
+{
+    std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred'";
+    std::mt19937 generator(benchmark_seed);
+
+    while (sql.length() < length)
+    {
+        sql += " AND NAME<>'user" + std::to_string(generator() % 100000) + "'";
+    }
+    return sql;
+}
+
+// query lengths from 64 bytes to 16 KB. the padding's conditions nest one expression deeper each, and much past 16 KB
+// they go over SQLite's expression depth limit (1000), where every run would measure an error instead of a query
+static void query_lengths(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(4)->Range(64, 16 << 10);
+}
+
+// query lengths from 50 bytes to 64 KB, for the screen on its own
+static void screen_lengths(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->Arg(50)->RangeMultiplier(4)->Range(64, 64 << 10);
+}
+
+// the screen run_query used before contains_tautology: a lowercased copy searched with a regex built on every call
+static bool regex_screen(const std::string& sql)
+{
+    std::string localCopy(sql);
+    std::transform(localCopy.begin(), localCopy.end(), localCopy.begin(), ::tolower);
+    std::regex pattern(R"(\b([a-z0-9']+)\s*=\s*\1\b)");
+    return std::regex_search(localCopy, pattern);
+}
+
+// the old screen over a clean query, which it has to search to the end
+static void BM_screen_regex(benchmark::State& state)
+{
+    const std::string sql = padded_query(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(regex_screen(sql));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sql.length()));
+}
+BENCHMARK(BM_screen_regex)->Apply(screen_lengths);
+
+// contains_tautology over the same queries
+static void BM_screen_scanner(benchmark::State& state)
+{
+    const std::string sql = padded_query(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(contains_tautology(sql));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sql.length()));
+}
+BENCHMARK(BM_screen_scanner)->Apply(screen_lengths);
+
+// an injection_screener over the same queries, fed 4 KB at a time as if read from a file
+static void BM_screen_stream(benchmark::State& state)
+{
+    const std::string sql = padded_query(static_cast<size_t>(state.range(0)));
+    const std::string_view text(sql);
+    injection_screener screener;
+
+    for (auto _ : state)
+    {
+        screener.reset();
+        for (size_t i = 0; i < text.length(); i += 4096)
+        {
+            screener.feed(text.substr(i, 4096));
+        }
+        screener.finish();
+        benchmark::DoNotOptimize(screener.suspicious());
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sql.length()));
+}
+BENCHMARK(BM_screen_stream)->Apply(screen_lengths);
+
+// a clean query that passes screening and runs against the database
+static void BM_run_query(benchmark::State& state)
+{
+    const benchmark_database database;
+    const std::string sql = padded_query(static_cast<size_t>(state.range(0)));
+    std::vector< user_record > records;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_query(database.db, sql, records));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sql.length()));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_run_query)->Apply(query_lengths);
+
+// the same query through the statement cache, so only the first run parses and plans it (and nothing screens it)
+static void BM_run_prepared_query(benchmark::State& state)
+{
+    const benchmark_database database;
+    statement_cache statements(database.db, 16);
+    const std::string sql = padded_query(static_cast<size_t>(state.range(0)));
+    const std::vector< std::string > no_parameters;
+    std::vector< user_record > records;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_prepared_query(statements, sql, no_parameters, records));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sql.length()));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_run_prepared_query)->Apply(query_lengths);
+
+// every user looked up by name in turn, the name written into the SQL text as run_queries does
+static void BM_run_query_by_name(benchmark::State& state)
+{
+    const benchmark_database database;
+    const std::string names[] = { "Fred", "Barney", "Wilma", "Betty" };
+    std::vector< user_record > records;
+    size_t next = 0;
+
+    for (auto _ : state)
+    {
+        const std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='" + names[next++ % 4] + "'";
+        benchmark::DoNotOptimize(run_query(database.db, sql, records));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_run_query_by_name);
+
+// the same lookups as one cached statement with the name bound to it
+static void BM_run_prepared_query_by_name(benchmark::State& state)
+{
+    const benchmark_database database;
+    statement_cache statements(database.db, 16);
+    const std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME=?1";
+    const std::vector< std::string > names[] = { { "Fred" }, { "Barney" }, { "Wilma" }, { "Betty" } };
+    std::vector< user_record > records;
+    size_t next = 0;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_prepared_query(statements, sql, names[next++ % 4], records));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_run_prepared_query_by_name);
+
+// the same lookups through a result cache, which only reaches SQLite the first time each name is looked up
+static void BM_cached_query_by_name(benchmark::State& state)
+{
+    const benchmark_database database;
+    result_cache cache(database.db, 64);
+    const std::string names[] = { "Fred", "Barney", "Wilma", "Betty" };
+    result_cache::shared_records records;
+    size_t next = 0;
+
+    for (auto _ : state)
+    {
+        const std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='" + names[next++ % 4] + "'";
+        benchmark::DoNotOptimize(cache.query(sql, records));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_cached_query_by_name);
+
+// the prepared lookups through a result cache
+static void BM_cached_prepared_query_by_name(benchmark::State& state)
+{
+    const benchmark_database database;
+    statement_cache statements(database.db, 16);
+    result_cache cache(database.db, 64);
+    const std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME=?1";
+    const std::vector< std::string > names[] = { { "Fred" }, { "Barney" }, { "Wilma" }, { "Betty" } };
+    result_cache::shared_records records;
+    size_t next = 0;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cache.query(statements, sql, names[next++ % 4], records));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_cached_prepared_query_by_name);
+
+// a tautology the screen blocks, so this measures the screening on its own
+static void BM_run_query_blocked(benchmark::State& state)
+{
+    const benchmark_database database;
+    const std::string sql = padded_query(static_cast<size_t>(state.range(0))) + " or 1=1;";
+    std::vector< user_record > records;
+    const silence_cout quiet;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_query(database.db, sql, records));
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sql.length()));
+}
+BENCHMARK(BM_run_query_blocked)->Apply(query_lengths);
+
+// the exercise's random injection mix, seeded so every run picks the same variants
+static void BM_run_query_injection(benchmark::State& state)
+{
+    const benchmark_database database;
+    const std::string sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred'";
+    std::vector< user_record > records;
+    const silence_cout quiet;
+    srand(benchmark_seed);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_query_injection(database.db, sql, records));
+    }
+}
+BENCHMARK(BM_run_query_injection);
+
+// every row of the table through sqlite3_exec and callback, three strings allocated per row
+static void BM_read_all_run_query(benchmark::State& state)
+{
+    const benchmark_database database;
+    add_users(database.db, static_cast<size_t>(state.range(0)));
+    std::vector< user_record > records;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_query(database.db, "SELECT * from USERS", records));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_all_run_query)->Apply(table_sizes);
+
+// the same rows stepped from a cached statement into user_records, still three strings per row
+static void BM_read_all_prepared_records(benchmark::State& state)
+{
+    const benchmark_database database;
+    add_users(database.db, static_cast<size_t>(state.range(0)));
+    statement_cache statements(database.db, 16);
+    const std::vector< std::string > no_parameters;
+    std::vector< user_record > records;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(run_prepared_query(statements, "SELECT * from USERS", no_parameters, records));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_all_prepared_records)->Apply(table_sizes);
+
+// the same rows into a reused user_result_set, which allocates nothing once it has held the table
+static void BM_read_all_result_set(benchmark::State& state)
+{
+    const benchmark_database database;
+    add_users(database.db, static_cast<size_t>(state.range(0)));
+    statement_cache statements(database.db, 16);
+    const std::vector< std::string > no_parameters;
+    user_result_set results;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(read_prepared_query(statements, "SELECT * from USERS", no_parameters, results));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_all_result_set)->Apply(table_sizes);
+
+// the NAME='Fred' lookup on a table of the given size, prepared, without the lookup indexes (a scan of every row) and
+// with them (a search of USERS_NAME)
+static void BM_lookup_by_name(benchmark::State& state, bool indexed)
+{
+    const benchmark_database database;
+    add_users(database.db, static_cast<size_t>(state.range(0)));
+    if (indexed)
+    {
+        create_lookup_indexes(database.db);
+    }
+    statement_cache statements(database.db, 16);
+    const std::vector< std::string > fred = { "Fred" };
+    user_result_set results;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(read_prepared_query(statements, "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME=?1", fred, results));
+    }
+}
+BENCHMARK_CAPTURE(BM_lookup_by_name, scan, false)->Apply(table_sizes);
+BENCHMARK_CAPTURE(BM_lookup_by_name, indexed, true)->Apply(table_sizes);
+
+// users 5 onwards as a bulk loader's CSV or binary input, with the same made up names and passwords as the generator
+static std::string user_rows_text(size_t count, bool binary)
+{
+    std::ostringstream output;
+    generated_user_reader reader(5, count);
+    user_row row;
+    while (reader.next(row))
+    {
+        if (binary)
+        {
+            write_user_row(output, row);
+        }
+        else
+        {
+            output << row.id << ',' << row.name << ',' << row.password << '\n';
+        }
+    }
+    return output.str();
+}
+
+// count users inserted the way initialize_database does, an INSERT of literals run by sqlite3_exec, each its own transaction
+static void BM_insert_each_row(benchmark::State& state)
+{
+    const size_t count = static_cast<size_t>(state.range(0));
+    std::optional<benchmark_database> database;
+
+    for (auto _ : state)
+    {
+        // a fresh table each time, with the last one closed, untimed
+        state.PauseTiming();
+        database.reset();
+        database.emplace();
+        state.ResumeTiming();
+
+        for (size_t id = 5; id < 5 + count; ++id)
+        {
+            const std::string sql = "INSERT INTO USERS (ID, NAME, PASSWORD) VALUES (" + std::to_string(id) + ", 'user"
+                + std::to_string(id) + "', 'password" + std::to_string(id) + "');";
+            sqlite3_exec(database->db, sql.c_str(), NULL, NULL, NULL);
+        }
+
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_insert_each_row)->Apply(table_sizes);
+
+// the same users through bulk_load_users, from the generator, CSV text and binary
+static void BM_bulk_load(benchmark::State& state, int source)
+{
+    const size_t count = static_cast<size_t>(state.range(0));
+    const std::string text = source == 0 ? std::string() : user_rows_text(count, source == 2);
+    const silence_cout quiet;
+    std::optional<benchmark_database> database;
+    std::istringstream input;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        database.reset();
+        database.emplace();
+        input.clear();
+        input.str(text);
+        state.ResumeTiming();
+
+        if (source == 0)
+        {
+            generated_user_reader reader(5, count);
+            benchmark::DoNotOptimize(bulk_load_users(database->db, reader));
+        }
+        else if (source == 1)
+        {
+            csv_user_reader reader(input);
+            benchmark::DoNotOptimize(bulk_load_users(database->db, reader));
+        }
+        else
+        {
+            binary_user_reader reader(input);
+            benchmark::DoNotOptimize(bulk_load_users(database->db, reader));
+        }
+
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_bulk_load, generated, 0)->Apply(table_sizes);
+BENCHMARK_CAPTURE(BM_bulk_load, csv, 1)->Apply(table_sizes);
+BENCHMARK_CAPTURE(BM_bulk_load, binary, 2)->Apply(table_sizes);
+
+// the run_queries mix, 100 rounds of it, over a pool of threads on a shared-cache in-memory database, as SQL text
+// through run_query or prepared, with the latency percentiles of the last run
+static void BM_concurrent_queries(benchmark::State& state, bool prepared)
+{
+    const size_t thread_count = static_cast<size_t>(state.range(0));
+    const silence_cout quiet;
+    connection_pool pool("file:concurrent_queries_benchmark?mode=memory&cache=shared", thread_count);
+    {
+        const connection_pool::lease connection = pool.acquire();
+        initialize_database(connection.db());
+    }
+    const std::vector< load_query > queries = make_query_mix(100, prepared, benchmark_seed);
+    load_result result;
+
+    for (auto _ : state)
+    {
+        result = run_concurrent_queries(pool, queries, thread_count);
+    }
+
+    std::sort(result.latencies.begin(), result.latencies.end());
+    state.counters["p50_us"] = std::chrono::duration<double, std::micro>(latency_percentile(result.latencies, 50)).count();
+    state.counters["p99_us"] = std::chrono::duration<double, std::micro>(latency_percentile(result.latencies, 99)).count();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(queries.size()));
+}
+BENCHMARK_CAPTURE(BM_concurrent_queries, screened, false)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_concurrent_queries, prepared, true)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();